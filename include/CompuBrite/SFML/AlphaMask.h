@@ -0,0 +1,103 @@
+/**
+ * The MIT License (MIT)
+ *
+ * @copyright
+ * Copyright (c) 2020 Rich Newman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @file
+ * @brief Interface for AlphaMask
+*/
+
+#ifndef COMPUBRITE_SFML_ALPHAMASK_H
+#define COMPUBRITE_SFML_ALPHAMASK_H
+
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/Graphics/Transform.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace sf {
+class Image;
+}
+
+namespace CompuBrite::SFML {
+
+/// A 1-bit mask of the solid pixels of part of an image, used by
+/// CollisionSystem for pixel perfect collisions.  Each row is packed into
+/// 64-bit words, so overlaps are tested 64 pixels at a time.  Pixel (x, y)
+/// of the mask covers the square from (x, y) to (x + 1, y + 1) in the local
+/// space of the IEntity it belongs to.
+/// @see ResourceManager::loadMask, SpriteEntity::setAlphaMask
+class AlphaMask
+{
+public:
+    /// Construct an empty mask.
+    AlphaMask() = default;
+
+    /// Construct the mask of part of an image.
+    /// @param image The image.
+    /// @param rect The part of the image, (e.g. a sprite's texture
+    /// rectangle).  It is clipped to the image, and a negative width or
+    /// height mirrors the mask, as it does the sprite.
+    /// @param threshold Pixels with at least this alpha are solid.
+    AlphaMask(const sf::Image &image, const sf::IntRect &rect, std::uint8_t threshold = 128);
+
+    ~AlphaMask() = default;
+
+    /// @return The width of the mask in pixels.
+    unsigned getWidth() const                    { return width_; }
+
+    /// @return The height of the mask in pixels.
+    unsigned getHeight() const                   { return height_; }
+
+    /// @return true if the given pixel is solid, false if it is clear or
+    /// outside the mask.
+    bool test(int x, int y) const;
+
+    /// @return The 64 pixels of row y starting at column x, pixel x in the
+    /// lowest bit.  Pixels outside the mask are clear.
+    std::uint64_t getBits(int x, int y) const;
+
+    /// Test this mask against another mask, or a solid rectangle.
+    /// @param transform From this mask's local space to the other's.
+    /// @param other The other mask, or nullptr if the other is solid.
+    /// @param otherRect The other's local bounds, (only the solid part if
+    /// other is nullptr).
+    /// @return true if a solid pixel of this mask overlaps a solid pixel, (or
+    /// the rectangle), of the other.
+    bool overlaps(const sf::Transform &transform, const AlphaMask *other,
+                  const sf::FloatRect &otherRect) const;
+
+private:
+    /// @return Word x of row y, 0 if outside the row.
+    std::uint64_t word(int x, int y) const
+    {
+        return (x < 0 || x >= static_cast<int>(words_)) ? 0 : bits_[y * words_ + x];
+    }
+
+    unsigned                   width_{0};
+    unsigned                   height_{0};
+    std::size_t                words_{0};   ///!< Words per row
+    std::vector<std::uint64_t> bits_;
+};
+
+} // namespace CompuBrite::SFML
+
+#endif // COMPUBRITE_SFML_ALPHAMASK_H
@@ -0,0 +1,110 @@
+/**
+ * The MIT License (MIT)
+ *
+ * @copyright
+ * Copyright (c) 2020 Rich Newman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @file
+ * @brief Interface for BitmapTextEntity
+*/
+
+#ifndef COMPUBRITE_SFML_BITMAPTEXTENTITY_H
+#define COMPUBRITE_SFML_BITMAPTEXTENTITY_H
+
+#include <CompuBrite/SFML/IEntity.h>
+#include <CompuBrite/SFML/IBatchable.h>
+#include <CompuBrite/SFML/GlyphAtlas.h>
+
+#include <SFML/Graphics/Color.hpp>
+#include <SFML/Graphics/Vertex.hpp>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace CompuBrite::SFML {
+
+/// Text drawn from the prebaked glyphs of a GlyphAtlas instead of sf::Text.
+/// All BitmapTextEntity objects sharing an atlas share its texture, so
+/// DrawingSystem batches them with each other, (and with sprites of the same
+/// texture), into a single draw call.  The character size only scales the
+/// glyphs; nothing is rasterised again.  Characters missing from the atlas
+/// are skipped, and '\n' starts a new line.
+/// @see GlyphAtlas
+class BitmapTextEntity : public CompuBrite::SFML::IEntity,
+                         public CompuBrite::SFML::IBatchable
+{
+public:
+    /// Construct the text.
+    /// @param atlas The glyphs to use, which must outlive this entity.
+    /// @param string The text to show, as Latin-1.
+    /// @param size The character size in pixels, or 0 for the size the atlas
+    /// was baked at.
+    explicit BitmapTextEntity(const GlyphAtlas &atlas, std::string_view string = "",
+                              float size = 0.0f);
+
+    virtual ~BitmapTextEntity() = default;
+
+    /// Set the text shown.  Does nothing if the text doesn't change.
+    void setString(std::string_view string);
+
+    /// @return The text shown.
+    const std::string &getString() const        { return string_; }
+
+    /// Set the character size, in pixels.
+    void setCharacterSize(float size);
+
+    /// @return The character size, in pixels.
+    float getCharacterSize() const               { return size_; }
+
+    /// Set the colour of the text.
+    void setFillColor(const sf::Color &color);
+
+    /// @return The colour of the text.
+    const sf::Color &getFillColor() const        { return color_; }
+
+    /// @return The bounds of the glyphs.
+    sf::FloatRect getLocalBounds() const override;
+
+    /// @return The texture of the GlyphAtlas.
+    const sf::Texture *getBatchTexture() const override;
+
+    /// Append the triangles of the glyphs to vertices, with their positions
+    /// transformed by the given transform.
+    void appendTriangles(std::vector<sf::Vertex> &vertices, const sf::Transform &transform) const override;
+
+protected:
+    /// Draw the glyphs with a single draw call.
+    void drawThis(sf::RenderTarget &target, sf::RenderStates states) const override;
+
+private:
+    /// Lay out the glyphs of the whole text.
+    void layout();
+
+    const GlyphAtlas *atlas_;
+    std::string string_;
+    float size_;
+    sf::Color color_{sf::Color::White};
+    std::vector<sf::Vertex> vertices_;           ///!< Six per visible glyph
+    sf::FloatRect bounds_;
+};
+
+} // namespace CompuBrite::SFML
+
+#endif // COMPUBRITE_SFML_BITMAPTEXTENTITY_H
@@ -28,11 +28,11 @@
 #define COMPUBRITE_SMFL_CIRCLEENTITY_H
 
 #include <CompuBrite/SFML/IShapeEntity.h>
-#include <SFML/Graphics/CircleShape.hpp>
 
 namespace CompuBrite::SFML {
 
-/// A CircleEntity encapsulates sf::CircleShape.
+/// A CircleEntity is a regular polygon approximating a circle, with the
+/// same points as sf::CircleShape.
 /// @see IEntity
 class CircleEntity : public CompuBrite::SFML::IShapeEntity
 {
@@ -54,9 +54,12 @@ public:
     /// Set a new point count for the circle.
     void setPointCount(std::size_t count);
 
-protected:
+private:
+    /// Compute the points of the circle.
+    void updatePoints();
 
-    sf::CircleShape circle_;
+    float radius_;
+    std::size_t pointCount_;
 };
 
 } // namespace CompuBrite::SFML
@@ -27,19 +27,39 @@
 #ifndef COMPUBRITE_SFML_COLLISIONSYSTEM_H
 #define COMPUBRITE_SFML_COLLISIONSYSTEM_H
 
-#include <CompuBrite/hash_util.h>
 #include <CompuBrite/SFML/ISystem.h>
+#include <CompuBrite/SFML/DynamicTree.h>
+#include <CompuBrite/SFML/StaticTree.h>
+#include <CompuBrite/SFML/TransformJournal.h>
 
 #include <SFML/Graphics/Rect.hpp>
+#include <SFML/Graphics/Transform.hpp>
 
 #include <typeinfo.h>
+#include <array>
+#include <cstdint>
 #include <unordered_map>
 #include <functional>
+#include <type_traits>
+#include <vector>
 
 namespace CompuBrite::SFML {
 
+class AlphaMask;
+class DebugDraw;
+class IShapeEntity;
+class CircleEntity;
+class SpriteEntity;
+
 /// Detect collisions between IEntity objects, and dispatch handlers to deal
-/// with the detected collisions.
+/// with the detected collisions.  Candidate pairs are found with a
+/// DynamicTree, so only IEntity objects whose bounds are near each other are
+/// ever tested.  IEntity objects which never move can be made static, they
+/// are kept in a separate StaticTree and never tested against each other.
+/// A pair in which neither IEntity has moved since the last update isn't
+/// tested again, its last result is reused.  Moves are taken from the
+/// TransformJournal, so an IEntity moved through a plain sf::Transformable
+/// reference isn't noticed.
 class CollisionSystem : public CompuBrite::SFML::ISystem
 {
 public:
@@ -53,21 +73,51 @@ public:
     /// performed.
     enum Level {
         AABB,                 ///!< Axis-aligned Bounding Box
-        BB,                   ///!< Bounding box
-        SAT                   ///!< Separating Axis Theorem
+        BB,                   ///!< Bounding box, or the radius of CircleEntity
+                              ///!< objects.
+        SAT,                  ///!< Separating Axis Theorem, using the actual
+                              ///!< points of IShapeEntity objects, and the
+                              ///!< radius of CircleEntity objects.
+        PIXEL                 ///!< The solid pixels of SpriteEntity objects
+                              ///!< with an AlphaMask.  Anything else is solid
+                              ///!< across its bounding box.
     };
 
-    /// Encapsulate the type_info information.  This is used to help with
-    /// the collision handlers.
-    using TypeIDs = std::pair<const std::type_info*, const std::type_info*>;
+    /// When a handler is called for a pair of IEntity objects in contact.
+    enum Phase {
+        Touching,             ///!< Every update they are in contact
+        Begin,                ///!< The first update they are in contact
+        Stay,                 ///!< Every update in contact after the first
+        End,                  ///!< The first update they are no longer in
+                              ///!< contact.  The rect is the last one seen.
+        Phases
+    };
 
-    /// Encapsulate the handler function.
-    using Handler = std::pair<bool, std::function<void(IEntity &, IEntity&, const sf::FloatRect &)>>;
+    /// An oriented bounding box in world space, as used by the BB level.
+    struct OBB
+    {
+        sf::Vector2f                center;
+        std::array<sf::Vector2f, 2> axes;  ///!< Unit length, local x and y
+        sf::Vector2f                half;  ///!< Half extents along the axes
+    };
+
+    /// The closest IEntity hit by a raycast.
+    struct RayHit
+    {
+        IEntity      *entity{nullptr};
+        float         distance{0.0f};     ///!< From the start of the ray
+        sf::Vector2f  point;              ///!< Where the ray hit, world space
+    };
+
+    /// The type erased form of a collision handler.
+    using Callback = std::function<void(IEntity &, IEntity&, const sf::FloatRect &)>;
 
     /// Construct the CollionSystem with the given level of detection
     /// precision.
     /// @param level The requested level of precision.
-    explicit CollisionSystem(Level level);
+    /// @param margin How far each IEntity's broad-phase box is fattened.
+    /// Movement within this margin does not touch the DynamicTree.
+    explicit CollisionSystem(Level level, float margin = 4.0f);
     virtual ~CollisionSystem() = default;
 
     /// Update the collision system.  This method is usually automatically
@@ -81,49 +131,311 @@ public:
     /// then the callback handler will be invoked.
     /// @tparam T1 The type for the first parameter of the callback function.
     /// @tparam T2 the type for the second parameter of the callback function.
+    /// @tparam Function Any callable as void(T1&, T2&, const sf::FloatRect&).
     /// @param callback The callback function.
-    template<typename T1, typename T2>
-    void addHandler(std::function<void(T1&, T2&, const sf::FloatRect &)> callback)
+    /// @param phase When to call the handler, by default every update the
+    /// objects are in contact.
+    /// @note Handlers may drop entities from this system; later contacts of a
+    /// dropped entity in the same update are skipped.
+    template<typename T1, typename T2, typename Function>
+    void addHandler(Function callback, Phase phase = Touching)
+    {
+        static_assert(std::is_invocable_v<const Function&, T1&, T2&, const sf::FloatRect&>,
+                      "A collision handler must be callable as "
+                      "void(T1&, T2&, const sf::FloatRect&)");
+        // The callable is stored directly, so dispatch is a single call.
+        registerHandler(phase, typeid(T1), typeid(T2),
+                        [callback = std::move(callback)]
+                        (IEntity &e1, IEntity &e2, const sf::FloatRect &rect)
+                        {
+                            callback(static_cast<T1&>(e1), static_cast<T2&>(e2), rect);
+                        });
+    }
+
+    /// Add a handler called once, when objects of the given types first come
+    /// into contact.  @see addHandler
+    template<typename T1, typename T2, typename Function>
+    void onBegin(Function callback)
+    {
+        addHandler<T1, T2>(std::move(callback), Begin);
+    }
+
+    /// Add a handler called every update objects of the given types remain in
+    /// contact, but not the first.  @see addHandler
+    template<typename T1, typename T2, typename Function>
+    void onStay(Function callback)
     {
-        auto t1 = &typeid(T1);
-        auto t2 = &typeid(T2);
-        auto handler = Handler(t2 < t1,
-                    [callback] (IEntity& e1, IEntity &e2, const sf::FloatRect &rect)
-                    {
-                        Dispatcher<T1, T2> cd(callback);
-                        cd(e1, e2, rect);
-                    });
-        auto types = std::minmax(t1, t2);
-        handlers_[types] = handler;
+        addHandler<T1, T2>(std::move(callback), Stay);
     }
 
+    /// Add a handler called once, when objects of the given types are no
+    /// longer in contact.  It isn't called if either object has been removed
+    /// from this system.  @see addHandler
+    template<typename T1, typename T2, typename Function>
+    void onEnd(Function callback)
+    {
+        addHandler<T1, T2>(std::move(callback), End);
+    }
+
+    /// Set the collision filter for an IEntity already added to this system.
+    /// Two IEntity objects are only tested against each other if each one's
+    /// category shares a bit with the other's mask.  Filtered pairs are
+    /// rejected inside the broad-phase, so they are never generated.
+    /// By default an IEntity has category 0x1 and collides with everything.
+    /// For example, bullets that shouldn't hit each other can be given
+    /// category 0x2 and mask ~0x2.  A category or mask of 0 disables collisions
+    /// for the IEntity entirely.
+    /// @param entity The IEntity to filter.
+    /// @param category The category bits of this IEntity.
+    /// @param mask The categories this IEntity collides with.
+    void setFilter(IEntity &entity, std::uint32_t category, std::uint32_t mask);
+
+    /// Turn continuous collision detection on or off for an IEntity already
+    /// added to this system.  A continuous IEntity has its bounding box swept
+    /// from where it was at the last update to where it is now, so a fast
+    /// mover can't pass through something thinner than its step.  The other
+    /// IEntity of a pair is swept too if it is also continuous, otherwise it
+    /// is taken at its current position.  Objects whose bounds overlap at the
+    /// end of the update are tested at the requested Level as usual.  The
+    /// sweep itself only uses the bounding boxes.
+    /// @param entity The IEntity to change.
+    /// @param continuous true to sweep the IEntity, false to only test where
+    /// it is now, (the default).
+    void setContinuous(IEntity &entity, bool continuous);
+
+    /// Find every IEntity whose global bounds intersect the given rectangle.
+    /// The spatial queries use the broad-phase, and see IEntity objects as
+    /// they were at the last update.
+    /// @param rect The rectangle, in world space.
+    /// @param mask Only IEntity objects with one of these category bits are
+    /// found, @see setFilter.
+    /// @return The IEntity objects found, in no particular order.
+    std::vector<IEntity*> queryAABB(const sf::FloatRect &rect, std::uint32_t mask = ~0u);
+
+    /// Find every IEntity whose bounding box contains the given point, (e.g.
+    /// what is under the mouse).  The box is tested in the IEntity's local
+    /// space, so a rotated IEntity is only found inside its rotated box.
+    /// @param point The point, in world space.
+    /// @param mask Only IEntity objects with one of these category bits are
+    /// found, @see setFilter.
+    /// @return The IEntity objects found, in no particular order.
+    std::vector<IEntity*> queryPoint(const sf::Vector2f &point, std::uint32_t mask = ~0u);
+
+    /// Find the closest IEntity whose bounding box is crossed by the segment
+    /// from, to, (e.g. for line of sight).  Like queryPoint, the box is tested
+    /// in the IEntity's local space.
+    /// @param from The start of the ray, in world space.
+    /// @param to The end of the ray, in world space.
+    /// @param[out] hit If an IEntity was hit, the closest hit.
+    /// @param mask Only IEntity objects with one of these category bits are
+    /// hit, @see setFilter.
+    /// @return true if an IEntity was hit.
+    bool raycast(const sf::Vector2f &from, const sf::Vector2f &to, RayHit &hit,
+                 std::uint32_t mask = ~0u);
+
+    /// Make an IEntity already added to this system static, or dynamic again.
+    /// A static IEntity must not move, it is only tested against dynamic
+    /// IEntity objects, and never against other static ones.  All static
+    /// IEntity objects are held in a StaticTree, which is built again on the
+    /// next update after any of them is added, removed, or changed.  Call
+    /// setStatic again if a static IEntity has been moved.
+    /// @param entity The IEntity to change.
+    /// @param fixed true to make the IEntity static, false to make it dynamic,
+    /// (the default).
+    void setStatic(IEntity &entity, bool fixed);
+
+    /// Only valid while a handler is being called.
+    /// @return The fraction of the last update, from 0 to 1, at which the
+    /// objects first touched.  0 if they were already in contact, and 1 for
+    /// pairs in which neither IEntity is continuous.
+    /// @see setContinuous
+    float timeOfImpact() const                       { return toi_; }
+
+    /// Show the state of this system in the given DebugDraw after every
+    /// update: the nodes of the broad-phase tree, the bounds of every
+    /// collider, and the intersection of every contact.
+    /// @param debug The DebugDraw to fill, or nullptr to stop.
+    /// @see DrawingSystem::addDebugDraw
+    void setDebugDraw(DebugDraw *debug);
+
 private:
-    /// Utility class to assist in dispatching the collions callbacks.
-    /// @tparam T1 The type of the first parameter to the callback
-    /// @tparam T2 The type of the second parameter to the callback
-    /// T1 and T2 must both be derived from IEntity.
-    template <typename T1, typename T2>
-    class Dispatcher
+    /// An entry of the handler table.
+    struct Handler
     {
-    public:
-        using Handler = std::function<void(T1 &, T2&, const sf::FloatRect &)>;
-
-        Dispatcher(const Handler &handler) :
-            handler_(handler)
-        { }
-
-        /// Dispatch the callback by safely downcasting the IEntity objects
-        /// To the types provided.
-        void operator()(IEntity &e1, IEntity &e2, const sf::FloatRect &rect)
-        {
-            handler_(static_cast<T1&>(e1), static_cast<T2&>(e2), rect);
-        }
-    private:
-        Handler handler_;
+        Callback callback;
+        bool     swap{false};              ///!< Call as (rhs, lhs)
     };
 
-private:
-    using Handlers = std::unordered_map<TypeIDs, Handler>;
+    /// A registration made while handlers were being dispatched.
+    struct Registration
+    {
+        Phase                 phase;
+        const std::type_info *t1;
+        const std::type_info *t2;
+        Callback              callback;
+    };
+
+    using TypeIDs = std::unordered_map<const std::type_info*, std::size_t>;
+    using Handlers = std::vector<std::array<Handler, Phases>>;
+
+    /// The broad-phase record for an IEntity.
+    struct Proxy
+    {
+        int               id{DynamicTree::Null};   ///!< Leaf in tree_
+        DynamicTree::AABB bounds;                  ///!< Bounds as of the last update
+        std::size_t       type{0};                 ///!< Row in handlers_
+        std::size_t       types{0};                ///!< types_ when type was found
+        std::uint32_t     category{0x1};           ///!< @see setFilter
+        std::uint32_t     mask{~0u};               ///!< @see setFilter
+        bool              continuous{false};       ///!< @see setContinuous
+        bool              fixed{false};            ///!< @see setStatic
+        const IShapeEntity *shape{nullptr};        ///!< If the IEntity is a shape
+        const CircleEntity *circle{nullptr};       ///!< If the IEntity is a circle
+        const SpriteEntity *sprite{nullptr};       ///!< If the IEntity is a sprite
+        std::size_t       index{0};                ///!< In colliders_ or statics_
+        TransformJournal::Frame frame{0};          ///!< Journal frame of the last update
+        std::uint32_t     version{0};              ///!< IEntity::getShapeVersion, as of the last update
+        sf::FloatRect     local;                   ///!< As of the last update
+        const AlphaMask  *pixels{nullptr};         ///!< As of the last update
+        bool              changed{false};          ///!< Filter changed since the last update
+    };
+
+    /// Everything the narrow-phase needs to know about an IEntity.  This is
+    /// computed once per update, so an IEntity in many candidate pairs
+    /// only has its matrices built once.
+    struct Collider
+    {
+        IEntity                    *entity;
+        std::size_t                 type;        ///!< Row in handlers_
+        std::uint32_t               category;    ///!< @see setFilter
+        std::uint32_t               mask;        ///!< @see setFilter
+        sf::Transform               transform;   ///!< Local to world
+        sf::Transform               inverse;     ///!< World to local
+        sf::FloatRect               local;       ///!< Local bounds
+        sf::FloatRect               bounds;      ///!< Global AABB
+        sf::FloatRect               swept;       ///!< bounds, and the last ones if continuous
+        sf::Vector2f                motion;      ///!< Since the last update if continuous
+        bool                        continuous;  ///!< @see setContinuous
+        bool                        fixed;       ///!< In statics_, @see setStatic
+        bool                        moved;       ///!< Changed since the last update
+        OBB                         obb;         ///!< BB level and up, not set for circles
+        bool                        box;         ///!< The outline is just the OBB
+        std::size_t                 first;       ///!< First point in xs_, ys_
+        std::size_t                 count;       ///!< Number of points
+        sf::Vector2f                center;      ///!< World space, circles only
+        float                       radius;      ///!< World space, 0 unless a circle
+        const AlphaMask            *pixels;      ///!< PIXEL level only, may be nullptr
+    };
+
+    /// A detected collision between two Colliders.
+    struct Contact
+    {
+        std::size_t   lhs;                 ///!< @see colliderAt
+        std::size_t   rhs;                 ///!< @see colliderAt
+        sf::FloatRect rect;                ///!< The intersection
+        bool          begin{false};        ///!< Not in contact last update
+        float         toi{1.0f};           ///!< @see timeOfImpact
+    };
+
+    /// A pair of IEntity objects in contact, kept from one update to the
+    /// next.  Ordered by address, so a pair has one entry either way round.
+    struct Touch
+    {
+        IEntity       *lhs;
+        IEntity       *rhs;
+        std::size_t    lhsType;            ///!< Row in handlers_
+        std::size_t    rhsType;            ///!< Row in handlers_
+        sf::FloatRect  rect;               ///!< The last intersection
+        bool           seen{false};        ///!< Still in contact this update
+    };
+
+    using Proxies = std::unordered_map<const IEntity*, Proxy>;
+    using Colliders = std::vector<Collider>;
+    using Pairs = std::vector<std::pair<std::size_t, std::size_t>>;
+    using Contacts = std::vector<Contact>;
+    using Touches = std::vector<Touch>;
+
+    /// Register the IEntity with the broad-phase.  Its leaf is created on
+    /// the next update, once it has been positioned.
+    void addProperties(IEntity &entity) override;
+
+    /// Remove the IEntity from the broad-phase, and forget its contacts.
+    /// No End handlers are called for them.
+    void dropProperties(IEntity &entity) override;
+
+    /// Build the Collider for every dynamic IEntity, and bring every leaf in
+    /// the DynamicTree up to date with it.  Rebuilds the static Colliders first
+    /// if they have changed.
+    void updateColliders();
+
+    /// Build the Collider for every static IEntity, and the StaticTree.
+    void buildStatics();
+
+    /// Build the Collider for the given IEntity.
+    /// @param entity The IEntity.
+    /// @param proxy The IEntity's broad-phase record.
+    /// @param xs, ys Where to add the IEntity's outline.
+    Collider makeCollider(IEntity *entity, Proxy &proxy,
+                          std::vector<float> &xs, std::vector<float> &ys);
+
+    /// Compute the OBB of the given Collider from its transform and local
+    /// bounds.  The axes are the columns of the transform, so a sheared
+    /// transform, (from a non-uniform scale under a rotated parent), only
+    /// gets an approximate box.
+    void makeOBB(Collider &collider);
+
+    /// Make the given Collider a true circle, if its CircleEntity has enough
+    /// points to look like one, and is under uniform scale.  Circles are
+    /// tested with closed forms from the BB level up.
+    void findCircle(Collider &collider, const Proxy &proxy);
+
+    /// Add the world space outline of the given Collider for the SAT level.
+    /// Shapes contribute their points, anything else contributes the corners
+    /// of its bounds.
+    void addOutline(Collider &collider, const Proxy &proxy,
+                    std::vector<float> &xs, std::vector<float> &ys);
+
+    /// Pairs and contacts refer to dynamic Colliders by their index in
+    /// colliders_, and static ones by their index in statics_ plus the
+    /// number of dynamic ones.
+    /// @return The Collider at the given index.
+    const Collider &colliderAt(std::size_t index) const
+    {
+        return index < colliders_.size() ? colliders_[index] : statics_[index - colliders_.size()];
+    }
+
+    /// Collect every pair of Colliders whose fat boxes overlap.
+    void findPairs();
+
+    /// Test all candidate pairs, splitting them across the ThreadPool when
+    /// there are enough of them.  Each chunk of pairs writes into its own
+    /// buffer, the buffers are then merged into contacts_.
+    /// @param target The Context providing the ThreadPool.
+    void narrowPhase(Context &target);
+
+    /// Add the contacts of the last update whose Colliders haven't moved
+    /// to contacts_, since testing them again would give the same result.
+    /// Then sort contacts_ so the result doesn't depend on scheduling.
+    void reuseContacts();
+
+    /// @return true if the given Collider has changed since the last update.
+    bool moved(const Collider &collider) const
+    {
+        return collider.fixed ? staticsMoved_ : collider.moved;
+    }
+
+    /// Test a pair in which at least one Collider is continuous.
+    /// @param rect If a collision was detected, then rect will contain the
+    /// boundary box of the detected collision, (where the boxes met if they
+    /// only touched during the update).
+    /// @param toi If a collision was detected, the time of impact.
+    /// @return true if a collision was detected, false otherwise.
+    bool didSweep(const Collider &lhs, const Collider &rhs, sf::FloatRect &rect, float &toi) const;
+
+    /// Test one chunk of the candidate pairs.
+    /// @param chunk Which chunk to test, also the buffer to write into.
+    /// @param chunks The total number of chunks.
+    void testPairs(std::size_t chunk, std::size_t chunks);
 
     /// Determine if the two given objects have collided.
     /// @param lhs The "left hand side" object
@@ -131,28 +443,71 @@ private:
     /// @param rect If a collision was detected, then rect will contain the
     /// boundary box of the detected collision.
     /// @return true if a collision was detected, false otherwise.
-    bool didCollide(const IEntity &lhs, const IEntity &rhs, sf::FloatRect &rect) const;
+    bool didCollide(const Collider &lhs, const Collider &rhs, sf::FloatRect &rect) const;
+
+    /// Compare this update's contacts with the last update's.  Flags which
+    /// contacts are beginning, and collects the ones that have ended.
+    void updateTouching();
+
+    /// Fill the DebugDraw, if any, with this update's state.
+    void debugDraw() const;
 
     /// Check for and handle collisions between all IEntity objects assigned
     /// to this CollisionSystem.
-    void checkCollisions() const;
+    /// @param target The Context providing the ThreadPool.
+    void checkCollisions(Context &target);
 
     /// A collision was detected between two objects, handle the collision by
-    /// dispatching the correct callback.
-    /// @param lhs The "left hand side" of the collision.
-    /// @param rhs The "Right hand side" of the collision.
-    /// @param rect The boundary box containing the point of collision.
-    void handleCollision(IEntity &lhs, IEntity &rhs, const sf::FloatRect &rect) const;
-
-    /// Find a handler for the given types.
-    /// @param p A std::pair of type_info pointers.  If a handler has been
-    /// registeredd for the given types, return it.
-    /// @return the given handler if it exists, otherwise return an empty
-    /// std::function
-    Handler find(const TypeIDs &p) const;
-
-    Handlers handlers_;
+    /// dispatching the Touching handler, and the Begin or Stay handler.
+    /// @param contact The detected collision.
+    void handleCollision(const Contact &contact) const;
+
+    /// Two objects are no longer in contact, dispatch the End handler.
+    /// @param touch The contact which has ended.
+    void handleEnd(const Touch &touch) const;
+
+    /// Call a handler, if it is set.
+    static void call(const Handler &handler, IEntity &lhs, IEntity &rhs, const sf::FloatRect &rect);
+
+    /// Add a type erased handler to the table, or queue it if handlers are
+    /// being dispatched.
+    void registerHandler(Phase phase, const std::type_info &t1, const std::type_info &t2,
+                         Callback callback);
+
+    /// Add a type erased handler to the table.
+    void insertHandler(Phase phase, const std::type_info &t1, const std::type_info &t2,
+                       Callback callback);
+
+    /// @return The compact identifier of the given type, assigning one if
+    /// needed.  Row and column 0 of the table are for types without any
+    /// handlers.
+    std::size_t typeID(const std::type_info &type);
+
+    TypeIDs typeIDs_;
+    Handlers handlers_{1};                 ///!< types x types, row major
+    std::size_t types_{1};
+    std::vector<Registration> pending_;
+    bool dispatching_{false};
     Level level_;
+    DynamicTree tree_;
+    Proxies proxies_;
+    Colliders colliders_;
+    std::vector<float> xs_;                ///!< Outline x coordinates
+    std::vector<float> ys_;                ///!< Outline y coordinates
+    StaticTree staticTree_;
+    Colliders statics_;
+    std::vector<float> staticXs_;
+    std::vector<float> staticYs_;
+    bool staticsDirty_{false};
+    bool staticsMoved_{false};             ///!< statics_ was rebuilt this update
+    std::size_t staticTypes_{0};           ///!< types_ when statics_ was built
+    Pairs pairs_;
+    std::vector<Contacts> buffers_;
+    Contacts contacts_;
+    Touches touching_;                     ///!< Sorted by (lhs, rhs)
+    Touches ended_;
+    float toi_{1.0f};                      ///!< @see timeOfImpact
+    DebugDraw *debug_{nullptr};            ///!< @see setDebugDraw
 };
 
 } // namespace CompuBrite::SFML
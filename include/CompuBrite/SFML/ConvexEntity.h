@@ -28,31 +28,26 @@
 #define COMPUBRITE_SFML_CONVEXENTITY_H
 
 #include <CompuBrite/SFML/IShapeEntity.h>
-#include <SFML/Graphics/ConvexShape.hpp>
 
 namespace CompuBrite::SFML {
 
-/// A ConvexEntity encapsulates sf::ConvexShape
+/// A ConvexEntity is a convex polygon, like sf::ConvexShape.
 /// @see IEntity.
 class ConvexEntity : public IShapeEntity
 {
 public:
-    /// Construct the ConvexShape with the given pointCount.
+    /// Construct the ConvexEntity with the given pointCount.
     /// @param pointCount The number of vertex points.
     explicit ConvexEntity(std::size_t pointCount = 0);
 
     /// Set a new point count.
     void setPointCount(std::size_t count);
 
-    /// Set the given vertex to the given x, y coordinates.
+    /// Set the given vertex to the given x, y coordinates.  The shared
+    /// geometry is only rebuilt once all points are set, when it is next read.
     /// @param index The vertex to set.
     /// @param point The x, y coordinates to set it to.
     void setPoint(std::size_t index, const sf::Vector2f &point);
-
-protected:
-
-private:
-    sf::ConvexShape shape_;
 };
 
 } // namespace CompuBrite::SFML
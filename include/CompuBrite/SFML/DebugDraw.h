@@ -0,0 +1,100 @@
+/**
+ * The MIT License (MIT)
+ *
+ * @copyright
+ * Copyright (c) 2020 Rich Newman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @file
+ * @brief Interface for DebugDraw
+*/
+#ifndef COMPUBRITE_SFML_DEBUGDRAW_H
+#define COMPUBRITE_SFML_DEBUGDRAW_H
+
+#include <SFML/Graphics/Color.hpp>
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/Graphics/RenderStates.hpp>
+#include <SFML/Graphics/Vertex.hpp>
+#include <SFML/System/Vector2.hpp>
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace sf {
+class RenderTarget;
+}
+
+namespace CompuBrite::SFML {
+
+/// Immediate-mode drawing of debugging shapes: lines, rectangles, circles and
+/// points, all outlined with lines.  Shapes are added from any thread, then
+/// present() publishes everything added since the previous present(), which
+/// draw() renders with a single draw call until the next present().  This
+/// lets a system running on the update thread, (e.g. CollisionSystem), show
+/// its state at its own rate while the render thread draws it every frame.
+/// @see DrawingSystem::addDebugDraw
+class DebugDraw
+{
+public:
+    DebugDraw() = default;
+
+    /// Add a line.
+    void line(const sf::Vector2f &from, const sf::Vector2f &to, const sf::Color &color);
+
+    /// Add the outline of a rectangle.
+    void rect(const sf::FloatRect &rect, const sf::Color &color);
+
+    /// Add the outline of a circle.
+    /// @param segments The number of lines approximating the circle.
+    void circle(const sf::Vector2f &center, float radius, const sf::Color &color,
+                std::size_t segments = 16);
+
+    /// Add a point, drawn as a small cross.
+    /// @param size The length of the arms of the cross.
+    void point(const sf::Vector2f &position, const sf::Color &color, float size = 3.0f);
+
+    /// Publish everything added since the last call, replacing what draw()
+    /// renders.
+    void present();
+
+    /// Forget everything added since the last present().
+    void clear();
+
+    /// Draw everything published by the last present() in one draw call.
+    /// @param target Where to draw.
+    /// @param states The sf::RenderStates to use.
+    void draw(sf::RenderTarget &target, sf::RenderStates states = sf::RenderStates::Default) const;
+
+    /// @return The number of lines published by the last present().
+    std::size_t getLineCount() const;
+
+private:
+    using Mutex = std::mutex;
+    using Lock = std::unique_lock<Mutex>;
+
+    mutable Mutex mutex_;
+    Lock lock() const                            { return Lock(mutex_); }
+
+    std::vector<sf::Vertex> building_;           ///!< Added since present()
+    std::vector<sf::Vertex> shown_;              ///!< Drawn by draw()
+};
+
+} // namespace CompuBrite::SFML
+
+#endif // COMPUBRITE_SFML_DEBUGDRAW_H
@@ -28,20 +28,58 @@
 #define COMPUBRITE_SFML_DRAWINGSYSTEM_H
 
 #include <CompuBrite/SFML/ISystem.h>
+#include <CompuBrite/SFML/DebugDraw.h>
+
+#include <SFML/Graphics/RenderStates.hpp>
+#include <SFML/Graphics/Vertex.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
 
 namespace CompuBrite::SFML {
 
+class IBatchable;
+
 /// A system to draw IEntity objects.  All IEntity objects added to this
 /// system will be drawn on the given target when the draw() method is called.
+///
+/// Entities are kept in a persistent queue sorted by a 64-bit key made of
+/// their "layer" property, zOrder, texture and blend mode, so entities of the
+/// same layer and zOrder are grouped by texture.  Each frame only the entries
+/// whose key changed are radix sorted and merged back into the queue.
+/// Consecutive IBatchable entities without children, (SpriteEntity,
+/// IShapeEntity, BitmapTextEntity, ...), that share a texture and blend mode
+/// are batched into a single draw call.
 class DrawingSystem : public CompuBrite::SFML::ISystem
 {
 public:
+    /// Counters describing the last call to draw().
+    struct Stats
+    {
+        std::size_t batched{0};     ///!< Entities drawn through a batch
+        std::size_t batches{0};     ///!< Batches submitted
+        std::size_t drawCalls{0};   ///!< Draw calls made on the target
+    };
+
     /// Construct the drawing system.
     /// @param boundingBoxes If true, then draw Axis-Aligned Bounding Boxes
-    /// around all entities.  This is useful for debugging, but very slow.
+    /// around all entities.  This is useful for debugging.
     explicit DrawingSystem(bool boundingBoxes = false);
     virtual ~DrawingSystem() = default;
 
+    /// @return The counters of the last call to draw().
+    Stats getStats() const                     { auto l = lock(); return stats_; }
+
+    /// Draw the given DebugDraw on top of the entities each frame.
+    /// @param debug The DebugDraw to draw.  It must outlive this system, or be
+    /// removed with dropDebugDraw().
+    void addDebugDraw(const DebugDraw &debug);
+
+    /// Stop drawing the given DebugDraw.
+    void dropDebugDraw(const DebugDraw &debug);
+
 protected:
     /// Draw all of the IEntity objects assigned to this DrawingSystem.
     /// This will call each IEntity's draw() method, passing along the target
@@ -51,7 +89,59 @@ protected:
     void draw(Context &target, sf::RenderStates states) const override;
 
 private:
+    /// Add the "layer" property to the given IEntity, and queue it for
+    /// drawing.  Entities are drawn by increasing layer first, then by
+    /// increasing zOrder.  Both are limited to the range of a 16 bit integer.
+    /// @param entity The IEntity to prepare.
+    void addProperties(IEntity &entity) override;
+
+    /// Remove the given IEntity from the drawing queue.
+    /// @param entity The IEntity being removed.
+    void dropProperties(IEntity &entity) override;
+
+    /// An entry of the drawing queue.
+    struct Item
+    {
+        std::uint64_t key;
+        IEntity *entity;
+        const IBatchable *batch;            ///!< entity, if it is IBatchable
+        const int *layer;                   ///!< The "layer" property
+        const sf::Texture *texture;         ///!< Texture last seen
+        std::uint32_t textureID;            ///!< Compact ID of texture
+    };
+
+    /// An entity to draw this frame.
+    struct Drawing
+    {
+        IEntity *entity;
+        const IBatchable *batch;
+    };
+
+    /// Refresh the keys of the queue and restore its order.  Only the entries
+    /// whose key changed, (or which were just added), are sorted.
+    void sortQueue() const;
+
+    /// Compute the sort key of the given entry, (updating its texture ID).
+    std::uint64_t sortKey(Item &item) const;
+
+    /// @return true if the given entity can be drawn in a batch.
+    static bool batchable(const Drawing &drawing);
+
+    /// Draw the pending batch, if any, and empty it.
+    void flush(sf::RenderTarget &target, const sf::RenderStates &states, Stats &stats) const;
+
     bool boundingBoxes_;
+    mutable DebugDraw boxes_;                   ///!< The bounding boxes
+    std::vector<const DebugDraw*> debugDraws_;
+    mutable std::vector<Item> queue_;           ///!< Sorted by key
+    mutable std::vector<Item> added_;           ///!< Not yet in queue_
+    mutable std::vector<Item> changed_;         ///!< Re-keyed this frame
+    mutable std::vector<Item> scratch_;         ///!< Sorting buffer
+    mutable std::vector<Drawing> drawings_;     ///!< This frame's order
+    mutable std::unordered_map<const sf::Texture*, std::uint32_t> textureIDs_;
+    mutable std::vector<sf::BlendMode> blendModes_;
+    mutable std::vector<sf::Vertex> vertices_;  ///!< Pending batch, reused
+    mutable Stats stats_;
 };
 
 } // namespace CompuBrite::SFML
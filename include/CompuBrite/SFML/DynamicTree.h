@@ -0,0 +1,370 @@
+/**
+ * The MIT License (MIT)
+ *
+ * @copyright
+ * Copyright (c) 2020 Rich Newman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @file
+ * @brief Interface for DynamicTree
+*/
+
+#ifndef COMPUBRITE_SFML_DYNAMICTREE_H
+#define COMPUBRITE_SFML_DYNAMICTREE_H
+
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/System/Vector2.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace CompuBrite::SFML {
+
+class IEntity;
+
+/// A dynamic bounding volume hierarchy used as the broad-phase of
+/// CollisionSystem.  Each leaf, (or proxy), holds a "fat" Axis-Aligned
+/// Bounding Box which is larger than the IEntity it represents, so that small
+/// movements don't require the leaf to be reinserted.  The tree is kept
+/// balanced with AVL style rotations as leaves are inserted and removed.
+/// @see CollisionSystem
+class DynamicTree
+{
+public:
+    /// An Axis-Aligned Bounding Box stored as its lower and upper corners.
+    /// This form is much cheaper than sf::FloatRect for the unions and
+    /// containment tests the tree performs.
+    struct AABB
+    {
+        AABB() = default;
+        AABB(const sf::Vector2f &lower, const sf::Vector2f &upper) :
+            lower(lower), upper(upper)
+        { }
+
+        /// Construct from the given sf::FloatRect.
+        explicit AABB(const sf::FloatRect &rect) :
+            lower(rect.left, rect.top),
+            upper(rect.left + rect.width, rect.top + rect.height)
+        { }
+
+        /// @return This box as an sf::FloatRect.
+        sf::FloatRect rect() const
+        {
+            return sf::FloatRect(lower.x, lower.y, upper.x - lower.x, upper.y - lower.y);
+        }
+
+        /// @return The perimeter of this box, used as the insertion cost.
+        float perimeter() const
+        {
+            return 2.0f * ((upper.x - lower.x) + (upper.y - lower.y));
+        }
+
+        /// @return true if this box fully contains the other box.
+        bool contains(const AABB &other) const
+        {
+            return lower.x <= other.lower.x && lower.y <= other.lower.y &&
+                   other.upper.x <= upper.x && other.upper.y <= upper.y;
+        }
+
+        /// @return true if this box overlaps the other box.
+        bool overlaps(const AABB &other) const
+        {
+            return lower.x <= other.upper.x && other.lower.x <= upper.x &&
+                   lower.y <= other.upper.y && other.lower.y <= upper.y;
+        }
+
+        /// Clip a ray against this box.
+        /// @param from The start of the ray.
+        /// @param direction The ray runs from from to from + direction.
+        /// @param maxFraction Only hits closer than this fraction of
+        /// direction count.
+        /// @param[out] fraction Where the ray enters the box, 0 if it starts
+        /// inside.
+        /// @return true if the ray hits this box.
+        bool raycast(const sf::Vector2f &from, const sf::Vector2f &direction,
+                     float maxFraction, float &fraction) const
+        {
+            auto enter = 0.0f;
+            auto exit = maxFraction;
+            auto slab = [&](float start, float d, float lo, float hi) {
+                if (d == 0.0f) {
+                    return lo <= start && start <= hi;
+                }
+                auto t1 = (lo - start) / d;
+                auto t2 = (hi - start) / d;
+                if (t2 < t1) {
+                    std::swap(t1, t2);
+                }
+                enter = std::max(enter, t1);
+                exit = std::min(exit, t2);
+                return enter <= exit;
+            };
+            if (!slab(from.x, direction.x, lower.x, upper.x) ||
+                !slab(from.y, direction.y, lower.y, upper.y)) {
+                return false;
+            }
+            fraction = enter;
+            return true;
+        }
+
+        /// @return The smallest box containing both given boxes.
+        static AABB combine(const AABB &lhs, const AABB &rhs)
+        {
+            return AABB({std::min(lhs.lower.x, rhs.lower.x), std::min(lhs.lower.y, rhs.lower.y)},
+                        {std::max(lhs.upper.x, rhs.upper.x), std::max(lhs.upper.y, rhs.upper.y)});
+        }
+
+        sf::Vector2f lower;
+        sf::Vector2f upper;
+    };
+
+    /// The value used for "no node".
+    static constexpr int Null = -1;
+
+    /// Construct an empty tree.
+    /// @param margin The amount by which each leaf's box is fattened on all
+    /// sides.
+    explicit DynamicTree(float margin = 4.0f);
+    ~DynamicTree() = default;
+
+    /// Every category bit.
+    static constexpr std::uint32_t AllCategories = ~std::uint32_t(0);
+
+    /// Create a proxy, (leaf), for the given IEntity.
+    /// @param aabb The tight bounding box of the IEntity.
+    /// @param entity The IEntity that this proxy represents.
+    /// @param categories The category bits of this proxy, see query().
+    /// @return The proxy identifier, used for all subsequent calls.
+    int createProxy(const AABB &aabb, IEntity *entity,
+                    std::uint32_t categories = AllCategories);
+
+    /// Destroy the given proxy.
+    /// @param proxy The proxy identifier returned from createProxy.
+    void destroyProxy(int proxy);
+
+    /// Update the bounding box of the given proxy.  The proxy is only
+    /// reinserted into the tree if its new tight box has escaped its fat box,
+    /// (or the fat box has become far too large).
+    /// @param proxy The proxy to move.
+    /// @param aabb The new tight bounding box.
+    /// @param displacement The distance moved since the last call, used to
+    /// predict and extend the fat box in the direction of motion.
+    /// @return true if the proxy was reinserted.
+    bool moveProxy(int proxy, const AABB &aabb, const sf::Vector2f &displacement);
+
+    /// Change the category bits of the given proxy.
+    void setCategories(int proxy, std::uint32_t categories);
+
+    /// @return The category bits of the given proxy.
+    std::uint32_t getCategories(int proxy) const { return nodes_[proxy].categories; }
+
+    /// @return The IEntity associated with the given proxy.
+    IEntity *getEntity(int proxy) const          { return nodes_[proxy].entity; }
+
+    /// Set a caller defined index for the given proxy.  CollisionSystem uses
+    /// this to find a leaf's entry in its per-update cache.
+    void setIndex(int proxy, std::size_t index)  { nodes_[proxy].index = index; }
+
+    /// @return The caller defined index for the given proxy.
+    std::size_t getIndex(int proxy) const        { return nodes_[proxy].index; }
+
+    /// @return The fat bounding box for the given proxy.
+    const AABB &getFatAABB(int proxy) const      { return nodes_[proxy].aabb; }
+
+    /// @return The height of the tree, (0 for a single leaf).
+    int getHeight() const;
+
+    /// Visit every node of the tree, in no particular order.  Meant for
+    /// debugging and visualization.
+    /// @tparam Callback Callable as void(const AABB &aabb, int height),
+    /// height being 0 for leaves.
+    template<typename Callback>
+    void visit(Callback &&callback) const
+    {
+        for (auto &node : nodes_) {
+            if (node.height >= 0) {
+                callback(node.aabb, node.height);
+            }
+        }
+    }
+
+    /// Report every proxy whose fat box overlaps the given box.
+    /// @tparam Callback Callable as bool(int proxy).  Return false from the
+    /// callback to stop the query early.
+    /// @param aabb The box to query against.
+    /// @param callback Called for each overlapping proxy.
+    template<typename Callback>
+    void query(const AABB &aabb, Callback &&callback) const
+    {
+        query(aabb, AllCategories, std::forward<Callback>(callback));
+    }
+
+    /// Report every proxy whose fat box overlaps the given box, and which
+    /// shares a category bit with the given mask.  Each internal node holds
+    /// the union of its leaves' categories, so whole subtrees which can't
+    /// match are skipped.
+    /// @tparam Callback Callable as bool(int proxy).  Return false from the
+    /// callback to stop the query early.
+    /// @param aabb The box to query against.
+    /// @param mask Only proxies with one of these category bits are reported.
+    /// @param callback Called for each overlapping proxy.
+    template<typename Callback>
+    void query(const AABB &aabb, std::uint32_t mask, Callback &&callback) const
+    {
+        Stack stack;
+        stack.push(root_);
+        while (!stack.empty()) {
+            auto index = stack.pop();
+            if (index == Null) {
+                continue;
+            }
+            const auto &node = nodes_[index];
+            if (!(node.categories & mask) || !node.aabb.overlaps(aabb)) {
+                continue;
+            }
+            if (node.isLeaf()) {
+                if (!callback(index)) {
+                    return;
+                }
+            } else {
+                stack.push(node.child1);
+                stack.push(node.child2);
+            }
+        }
+    }
+
+    /// Cast a ray through the tree, reporting every proxy whose fat box it
+    /// hits, (nearest subtrees aren't visited first).  The callback clips the
+    /// ray, so proxies beyond the closest hit found so far are skipped.
+    /// @tparam Callback Callable as float(int proxy, float maxFraction).
+    /// Return the fraction of the ray at which the proxy's object was hit, or
+    /// maxFraction if it wasn't.  Returning 0 ends the raycast.
+    /// @param from The start of the ray.
+    /// @param to The end of the ray.
+    /// @param mask Only proxies with one of these category bits are reported.
+    /// @param callback Called for each proxy hit.
+    template<typename Callback>
+    void raycast(const sf::Vector2f &from, const sf::Vector2f &to, std::uint32_t mask,
+                 Callback &&callback) const
+    {
+        const auto direction = to - from;
+        auto maxFraction = 1.0f;
+        Stack stack;
+        stack.push(root_);
+        while (!stack.empty()) {
+            auto index = stack.pop();
+            if (index == Null) {
+                continue;
+            }
+            const auto &node = nodes_[index];
+            float fraction;
+            if (!(node.categories & mask) ||
+                !node.aabb.raycast(from, direction, maxFraction, fraction)) {
+                continue;
+            }
+            if (node.isLeaf()) {
+                const auto value = callback(index, maxFraction);
+                if (value == 0.0f) {
+                    return;
+                }
+                maxFraction = std::min(maxFraction, value);
+            } else {
+                stack.push(node.child1);
+                stack.push(node.child2);
+            }
+        }
+    }
+
+private:
+    /// A node in the tree.  Leaves hold an IEntity, internal nodes have two
+    /// children.  Free nodes are chained through parent.
+    struct Node
+    {
+        bool isLeaf() const                      { return child1 == Null; }
+
+        AABB          aabb;
+        IEntity      *entity{nullptr};
+        std::size_t   index{0};
+        std::uint32_t categories{0};       ///!< Union of the leaves below
+        int           parent{Null};
+        int           child1{Null};
+        int           child2{Null};
+        int           height{-1};          ///!< leaf = 0, free = -1
+    };
+
+    /// Traversal stack for queries.  It avoids allocating for any reasonably
+    /// balanced tree and grows onto the heap otherwise.
+    class Stack
+    {
+    public:
+        void push(int index)
+        {
+            if (size_ < fixed_.size()) {
+                fixed_[size_++] = index;
+            } else {
+                overflow_.push_back(index);
+            }
+        }
+
+        int pop()
+        {
+            if (!overflow_.empty()) {
+                auto index = overflow_.back();
+                overflow_.pop_back();
+                return index;
+            }
+            return fixed_[--size_];
+        }
+
+        bool empty() const                       { return size_ == 0 && overflow_.empty(); }
+
+    private:
+        std::array<int, 256> fixed_;
+        std::size_t          size_{0};
+        std::vector<int>     overflow_;
+    };
+
+    int allocateNode();
+    void freeNode(int index);
+
+    /// Insert the given leaf, picking the sibling which least increases the
+    /// total perimeter of the tree.
+    void insertLeaf(int leaf);
+
+    /// Remove the given leaf, (and its parent), from the tree.
+    void removeLeaf(int leaf);
+
+    /// Perform a left or right rotation if the node at index is imbalanced.
+    /// @return The index of the new subtree root.
+    int balance(int index);
+
+    /// Walk from index to the root, rebalancing and refitting each ancestor.
+    void refit(int index);
+
+    std::vector<Node> nodes_;
+    int               root_{Null};
+    int               freeList_{Null};
+    float             margin_;
+};
+
+} // namespace CompuBrite::SFML
+
+#endif // COMPUBRITE_SFML_DYNAMICTREE_H
@@ -0,0 +1,98 @@
+/**
+ * The MIT License (MIT)
+ *
+ * @copyright
+ * Copyright (c) 2020 Rich Newman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @file
+ * @brief Interface for GlyphAtlas
+*/
+
+#ifndef COMPUBRITE_SFML_GLYPHATLAS_H
+#define COMPUBRITE_SFML_GLYPHATLAS_H
+
+#include <SFML/Graphics/Font.hpp>
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/Graphics/Texture.hpp>
+
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+
+namespace CompuBrite::SFML {
+
+/// A set of glyphs of a font, rasterised once at a single character size and
+/// packed into a texture of their own.  Every BitmapTextEntity using the same
+/// GlyphAtlas shares that texture, so DrawingSystem can draw all of them in a
+/// single batch, and each may be scaled to any size without rasterising the
+/// glyphs again.  Bake the atlas at the largest size shown; smaller text is
+/// scaled down through the smoothed texture.
+/// @see BitmapTextEntity
+class GlyphAtlas
+{
+public:
+    /// The characters baked by default: printable ASCII.
+    static constexpr std::string_view Printable =
+        " !\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`"
+        "abcdefghijklmnopqrstuvwxyz{|}~";
+
+    /// Where a glyph lives in the atlas, and how to place it.
+    struct Glyph
+    {
+        sf::FloatRect bounds;       ///!< Relative to the pen, on the baseline
+        sf::IntRect rect;           ///!< Within the texture
+        float advance;              ///!< Distance to the next pen position
+    };
+
+    /// Rasterise and pack the given characters.
+    /// @param font The font to use, which must outlive this GlyphAtlas.
+    /// @param size The character size to rasterise at, in pixels.
+    /// @param characters The characters to bake, as Latin-1.
+    GlyphAtlas(const sf::Font &font, unsigned int size,
+               std::string_view characters = Printable);
+
+    GlyphAtlas(const GlyphAtlas&) = delete;
+    GlyphAtlas& operator=(const GlyphAtlas&) = delete;
+
+    /// @return The glyph of the given character, or nullptr if it was not
+    /// baked.
+    const Glyph *getGlyph(std::uint32_t character) const;
+
+    /// @return The kerning between two characters, at the baked size.
+    float getKerning(std::uint32_t first, std::uint32_t second) const;
+
+    /// @return The distance between two lines, at the baked size.
+    float getLineSpacing() const;
+
+    /// @return The character size the glyphs were rasterised at.
+    unsigned int getCharacterSize() const         { return size_; }
+
+    /// @return The texture holding every glyph.
+    const sf::Texture &getTexture() const         { return texture_; }
+
+private:
+    const sf::Font *font_;
+    unsigned int size_;
+    sf::Texture texture_;
+    std::unordered_map<std::uint32_t, Glyph> glyphs_;
+};
+
+} // namespace CompuBrite::SFML
+
+#endif // COMPUBRITE_SFML_GLYPHATLAS_H
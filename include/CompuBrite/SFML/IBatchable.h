@@ -0,0 +1,72 @@
+/**
+ * The MIT License (MIT)
+ *
+ * @copyright
+ * Copyright (c) 2020 Rich Newman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @file
+ * @brief Interface for IBatchable
+*/
+
+#ifndef COMPUBRITE_SFML_IBATCHABLE_H
+#define COMPUBRITE_SFML_IBATCHABLE_H
+
+#include <SFML/Graphics/BlendMode.hpp>
+#include <SFML/Graphics/Texture.hpp>
+#include <SFML/Graphics/Transform.hpp>
+#include <SFML/Graphics/Vertex.hpp>
+
+#include <vector>
+
+namespace CompuBrite::SFML {
+
+/// IBatchable is implemented by IEntity classes which can be drawn as plain
+/// triangles, so that DrawingSystem can draw many of them with a single draw
+/// call.  Entities drawn together must share a texture and a blend mode.
+/// A derived class which overrides drawThis() must make sure the triangles
+/// still match what it draws, or return false from isBatchable().
+/// The IEntity is locked while these are called.
+/// @see DrawingSystem
+/// @see SpriteEntity
+/// @see IShapeEntity
+class IBatchable
+{
+public:
+    virtual ~IBatchable() = default;
+
+    /// @return true if the IEntity can currently be drawn in a batch.
+    virtual bool isBatchable() const              { return true; }
+
+    /// @return The texture of the triangles, or nullptr.
+    virtual const sf::Texture *getBatchTexture() const = 0;
+
+    /// @return The blend mode of the triangles.
+    virtual sf::BlendMode getBatchBlendMode() const { return sf::BlendAlpha; }
+
+    /// Append the triangles drawing the IEntity, (without its children), to
+    /// vertices, with their positions transformed by the given transform.
+    /// @param vertices Where to append the vertices, (sf::Triangles).
+    /// @param transform The transform to apply, usually the one of the
+    /// IEntity combined with the one of the target.
+    virtual void appendTriangles(std::vector<sf::Vertex> &vertices, const sf::Transform &transform) const = 0;
+};
+
+} // namespace CompuBrite::SFML
+
+#endif // COMPUBRITE_SFML_IBATCHABLE_H
@@ -31,10 +31,14 @@
 #include <SFML/System/Time.hpp>
 
 #include <CompuBrite/SFML/PropertyManager.h>
+#include <CompuBrite/SFML/TransformJournal.h>
 
 
+#include <atomic>
+#include <cstdint>
 #include <vector>
 #include <functional>
+#include <memory>
 #include <mutex>
 
 namespace CompuBrite::SFML {
@@ -48,13 +52,13 @@ class IEntity : public sf::Drawable, public sf::Transformable
 {
 public:
 
-    IEntity() = default;
+    IEntity();
 
     /// Construct this IEntity with the given zOrder
     /// @param zOrder zOrder layering lower numbers will be drawn first, other
     /// than that, the zOrder is arbitrary.
-    explicit IEntity(int zOrder) : zOrder_(zOrder) { }
-    virtual ~IEntity() = default;
+    explicit IEntity(int zOrder);
+    virtual ~IEntity();
 
     /// @return retrieve the local bounding box for this IEntity.  By default,
     /// IEntity will return an empty rectangle.  Derived classes *must*
@@ -111,6 +115,9 @@ public:
     /// any).
     sf::Transform getGlobalTransform() const;
 
+    /// @return true if this IEntity has any child IEntity objects.
+    bool hasChildren() const                      { auto l = lock(); return !children_.empty(); }
+
     /// @return The zOrder, (drawing order), for this IEntity.
     int zOrder() const                            { auto l = lock(); return zOrder_; }
 
@@ -122,7 +129,68 @@ public:
 
     Lock lock() const                            { return Lock(mutex_); }
 
+    /// The sf::Transformable setters, hidden here so that every change made
+    /// through an IEntity is recorded in the TransformJournal.  Changes made
+    /// through a plain sf::Transformable reference are not recorded.
+    /// These do not lock the IEntity, so they may be called while holding
+    /// lock(), as MovementSystem does.  A call which leaves the transform as
+    /// it was, (such as a zero move() or rotate()), records nothing.
+    /// @{
+    void setPosition(float x, float y);
+    void setPosition(const sf::Vector2f &position);
+    void setRotation(float angle);
+    void setScale(float factorX, float factorY);
+    void setScale(const sf::Vector2f &factors);
+    void setOrigin(float x, float y);
+    void setOrigin(const sf::Vector2f &origin);
+    void move(float offsetX, float offsetY);
+    void move(const sf::Vector2f &offset);
+    void rotate(float angle);
+    void scale(float factorX, float factorY);
+    void scale(const sf::Vector2f &factor);
+    /// @}
+
+    /// @return The TransformJournal shared by all IEntity objects.
+    static TransformJournal& journal();
+
+    /// Draw this IEntity and all of its children into a texture once, and
+    /// then draw that texture as a single quad every frame until something
+    /// in the subtree changes.  Useful for backgrounds, HUD panels and other
+    /// mostly static groups of entities.  The texture has one pixel per local
+    /// unit, so a cached subtree which is scaled up will look blurred.
+    /// @param cached true to cache the drawing, false to draw normally.
+    void setCached(bool cached);
+
+    /// @return true if the drawing of this subtree is cached.
+    bool isCached() const;
+
+    /// Mark the drawing of this IEntity as changed, so that its cached
+    /// subtree, (and those of its ancestors), are drawn again.  The setters
+    /// of the engine's entities call this; derived classes must call it when
+    /// they change how they are drawn.
+    void invalidate();
+
+    /// @return A number which changes whenever the shape of this IEntity
+    /// changes in a way its transform and bounds may not show, such as the
+    /// points of a shape or the texture rectangle of a sprite.
+    /// @see CollisionSystem
+    std::uint32_t getShapeVersion() const    { return shapeVersion_.load(std::memory_order_relaxed); }
+
+    /// @return The bounds of this IEntity and all of its children, in the
+    /// local coordinates of this IEntity.
+    sf::FloatRect getSubtreeBounds() const;
+
 private:
+    friend class TransformJournal;
+
+    /// Record a change of the transform in the journal, and mark the drawing
+    /// of the parent as changed.
+    void transformed();
+
+    /// Draw the cached texture of this subtree, drawing it again first if
+    /// something changed.
+    void drawCached(sf::RenderTarget &target, sf::RenderStates states) const;
+
     /// Draw all child IEntity objects associated with this IEntity.
     /// @param target Where to draw the children.
     /// @param states The sf::RenderStates to use for drawing.
@@ -160,9 +228,26 @@ protected:
     mutable Mutex mutex_;
     Children children_;
     Systems systems_;
-    IEntity *parent_{nullptr};
+    std::atomic<IEntity*> parent_{nullptr};   ///!< Atomic, as setters read it unlocked
     int zOrder_{0};
 
+    /// Mark the shape of this IEntity as changed, and invalidate() it.
+    /// Derived classes call this along with their geometry setters.
+    /// @see getShapeVersion
+    void reshaped();
+
+private:
+    struct Cache;
+
+    /// Last TransformJournal frame this IEntity was recorded in.
+    std::atomic<TransformJournal::Frame> journalFrame_{0};
+
+    /// @see getShapeVersion
+    std::atomic<std::uint32_t> shapeVersion_{0};
+
+    /// The texture of the cached subtree, if setCached().
+    std::unique_ptr<Cache> cache_;
+
 public:
     /// Properties to use for this IEntity.  These are usually used by
     /// the ISystem mechanism to handle various arbitrary properties.
@@ -28,17 +28,27 @@
 #define COMPUBRITE_SFML_ISHAPEENTITY_H
 
 #include <CompuBrite/SFML/IEntity.h>
+#include <CompuBrite/SFML/IBatchable.h>
+#include <CompuBrite/SFML/ShapeGeometry.h>
 #include <SFML/Graphics/Color.hpp>
-#include <SFML/Graphics/Shape.hpp>
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/Graphics/Texture.hpp>
+
+#include <vector>
 
 namespace CompuBrite::SFML {
 
 /// Forms the base class for CircleEntity, ConvexEntity, etc.
 /// This class provides all of the common interface methods for sf::Shape, and
-/// binds them with the IEntity interface.  This class delegates to sf::Shape
-/// to provide those interface requirements.
+/// binds them with the IEntity interface.  The tessellated geometry is a
+/// ShapeGeometry shared with every shape of the same points and outline
+/// thickness; each instance only keeps its points, colours and texture.
+/// Changing the points only marks the geometry stale, it is shared again
+/// the next time it is read.
 /// @see sf::Shape.
-class IShapeEntity : public CompuBrite::SFML::IEntity
+/// @see ShapeGeometry
+class IShapeEntity : public CompuBrite::SFML::IEntity,
+                     public CompuBrite::SFML::IBatchable
 {
 public:
     virtual ~IShapeEntity() = default;
@@ -92,22 +102,61 @@ public:
     /// @return The local Axis-Aligned Boundary Box for this object.
     sf::FloatRect getLocalBounds() const override;
 
+    /// @return The shared geometry of this shape.
+    const ShapeGeometry &getGeometry() const     { return geometry(); }
+
+    /// @return true if appendTriangles() can draw this shape, which is the
+    /// case unless it has both a texture and an outline.
+    bool isBatchable() const override;
+
+    /// @return The texture of the shape, or nullptr.
+    const sf::Texture *getBatchTexture() const override;
+
+    /// Append the triangles of the fill and the outline to vertices, with
+    /// their positions transformed by the given transform.  DrawingSystem uses
+    /// this to draw many shapes at once.
+    /// @param vertices Where to append the vertices.
+    /// @param transform The transform to apply, usually the one of this
+    /// IEntity combined with the one of the target.
+    void appendTriangles(std::vector<sf::Vertex> &vertices, const sf::Transform &transform) const override;
+
 protected:
     /// IShapeEntity can only be constructed through one of it's derived
     /// objects.
-    /// @param shape, The sf::Shape that is being managed through this
-    /// interface.
-    explicit IShapeEntity(sf::Shape &shape);
+    IShapeEntity();
 
-    /// Draw the sf::Shape which is bound to this IShapeEntity object.
-    /// This overrides IEntiry::draw() to provide the means to draw sf::Shape
-    /// derived objects.
+    /// Change the points of this shape.  Derived classes call this whenever
+    /// their parameters change.
+    /// @param points The points of the shape, in order.
+    void setPoints(const ShapeGeometry::Points &points);
+
+    /// @return The points of this shape, to be changed in place.  The
+    /// geometry is shared again the next time it is read, so editing many
+    /// points costs a single ShapeGeometry::share().
+    ShapeGeometry::Points &editPoints();
+
+    /// Draw the shared geometry with the colours and texture of this
+    /// IShapeEntity object.
     /// @param target Where to draw
     /// @param states The sf::RenderStates to use while drawing.
     void drawThis(sf::RenderTarget &target, sf::RenderStates states) const override;
 
-protected:
-    sf::Shape *shape_;
+private:
+    /// @return The shared geometry, sharing the points first if they changed.
+    const ShapeGeometry &geometry() const;
+
+    /// Append the vertices of the given geometry coloured with color.
+    /// The texture coordinates of the fill follow the texture rectangle.
+    void append(std::vector<sf::Vertex> &vertices, const ShapeGeometry::Vertices &geometry,
+                const sf::Transform &transform, const sf::Color &color, bool textured) const;
+
+    ShapeGeometry::Points points_;
+    mutable ShapeGeometry::Ptr geometry_;
+    mutable bool stale_{false};                  ///!< points_ changed since geometry_
+    const sf::Texture *texture_{nullptr};
+    sf::IntRect textureRect_;
+    sf::Color fillColor_{sf::Color::White};
+    sf::Color outlineColor_{sf::Color::White};
 };
 
 } // namespace CompuBrite::SFML
@@ -88,6 +88,13 @@ private:
     /// @see TProperty
     /// @param entity The entity to process and add properties.
     virtual void addProperties(IEntity &entity);
+
+    /// Release anything this ISystem keeps for the given IEntity.  This is
+    /// called from dropEntity.  By default does nothing, subclasses should
+    /// override it to undo the work of addProperties.
+    /// @see CollisionSystem
+    /// @param entity The entity being removed from this ISystem.
+    virtual void dropProperties(IEntity &entity);
 };
 
 } // namespace CompuBrite::SFML
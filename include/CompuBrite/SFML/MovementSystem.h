@@ -40,7 +40,9 @@ public:
 
     /// Update the position of all managed IEntity objects by applying their
     /// acceleration, rotation, and other properties.  Perform the required
-    /// transforms for each IEntity object.
+    /// transforms for each IEntity object.  Moved objects are recorded in
+    /// IEntity::journal().  Large updates are split across the ThreadPool,
+    /// but every entity has moved by the time this returns.
     /// @param dt The elapsed time since the last call to update().
     void update(Context &target, sf::Time dt) override;
 
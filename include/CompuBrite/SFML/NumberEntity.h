@@ -0,0 +1,122 @@
+/**
+ * The MIT License (MIT)
+ *
+ * @copyright
+ * Copyright (c) 2020 Rich Newman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @file
+ * @brief Interface for NumberEntity
+*/
+#ifndef COMPUBRITE_SFML_NUMBERENTITY_H
+#define COMPUBRITE_SFML_NUMBERENTITY_H
+
+#include <CompuBrite/SFML/IEntity.h>
+
+#include <SFML/Graphics/Color.hpp>
+#include <SFML/Graphics/Font.hpp>
+#include <SFML/Graphics/Vertex.hpp>
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace CompuBrite::SFML {
+
+/// Text showing a number between a fixed prefix and suffix, such as
+/// "Alt:   123.45" or "Fuel: 12 units".  Made for HUD values which change
+/// every update: the number is formatted with std::snprintf into a fixed
+/// buffer, an unchanged string is skipped entirely, and only the glyphs from
+/// the first changed character onward are laid out again.  Nothing is
+/// allocated once constructed, unless the prefix or suffix is changed.
+class NumberEntity : public CompuBrite::SFML::IEntity
+{
+public:
+    /// The longest text shown, prefix and suffix included.
+    static constexpr std::size_t Capacity = 64;
+
+    /// Construct the text.
+    /// @param font The font to use, which must outlive this NumberEntity.
+    /// @param size The character size, in pixels.
+    /// @param prefix Text shown before the number.
+    /// @param suffix Text shown after the number.
+    /// @param precision The number of decimals shown.
+    /// @param width The minimum width of the number, padded with spaces on
+    /// the left.
+    NumberEntity(const sf::Font &font, unsigned int size, std::string_view prefix = "",
+                 std::string_view suffix = "", int precision = 2, int width = 0);
+
+    virtual ~NumberEntity() = default;
+
+    /// Show the given value.  Does nothing if the text doesn't change.
+    void setValue(double value);
+
+    /// @return The last value given to setValue().
+    double getValue() const                      { return value_; }
+
+    /// Change the text shown before the number.
+    void setPrefix(std::string_view prefix);
+
+    /// Change the text shown after the number.
+    void setSuffix(std::string_view suffix);
+
+    /// Change the number of decimals shown.
+    void setPrecision(int precision);
+
+    /// Set the colour of the text.
+    void setFillColor(const sf::Color &color);
+
+    /// @return The colour of the text.
+    const sf::Color &getFillColor() const        { return color_; }
+
+    /// @return The text shown.
+    std::string_view getString() const           { return std::string_view(text_.data(), length_); }
+
+    /// @return The bounds of the glyphs.
+    sf::FloatRect getLocalBounds() const override;
+
+protected:
+    /// Draw the glyphs with a single draw call.
+    void drawThis(sf::RenderTarget &target, sf::RenderStates states) const override;
+
+private:
+    /// Format the text and lay out whatever changed.
+    void refresh();
+
+    /// Lay out the glyphs from the given character to the end of the text.
+    void layout(std::size_t from);
+
+    const sf::Font *font_;
+    unsigned int size_;
+    sf::Color color_{sf::Color::White};
+    std::string prefix_;
+    std::string suffix_;
+    int precision_;
+    int width_;
+    double value_{0.0};
+    std::array<char, Capacity> text_{};
+    std::size_t length_{0};
+    std::array<float, Capacity + 1> pens_{};     ///!< Pen position before each character
+    std::vector<sf::Vertex> vertices_;           ///!< Six per character
+    sf::FloatRect bounds_;
+};
+
+} // namespace CompuBrite::SFML
+
+#endif // COMPUBRITE_SFML_NUMBERENTITY_H
@@ -0,0 +1,185 @@
+/**
+ * The MIT License (MIT)
+ *
+ * @copyright
+ * Copyright (c) 2020 Rich Newman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @file
+ * @brief Interface for ParticleEntity
+*/
+
+#ifndef COMPUBRITE_SFML_PARTICLEENTITY_H
+#define COMPUBRITE_SFML_PARTICLEENTITY_H
+
+#include <CompuBrite/SFML/IEntity.h>
+
+#include <SFML/Graphics/BlendMode.hpp>
+#include <SFML/Graphics/Color.hpp>
+#include <SFML/Graphics/Texture.hpp>
+#include <SFML/Graphics/VertexArray.hpp>
+
+#include <cstddef>
+#include <random>
+#include <vector>
+
+namespace CompuBrite::SFML {
+
+class Context;
+
+/// Describes how a ParticleEntity makes new particles.  Each value with a
+/// min and a max is picked at random, uniformly, for every particle.  Angles
+/// are in degrees, 0 pointing along +x, as with sf::Transformable.
+struct ParticleEmitter
+{
+    float rate{100.0f};                      ///!< Particles per second
+    sf::Vector2f position;                   ///!< Local position of the emitter
+    sf::Vector2f spread;                     ///!< Half size of the emitting box
+    float direction{0.0f};                   ///!< Centre of the emitting cone
+    float angle{360.0f};                     ///!< Width of the emitting cone
+    float minSpeed{50.0f};
+    float maxSpeed{100.0f};
+    float minLife{1.0f};                     ///!< Seconds
+    float maxLife{1.0f};
+    float startSize{2.0f};                   ///!< Side of the square, at birth
+    float endSize{2.0f};                     ///!< Side of the square, at death
+    sf::Color startColor{sf::Color::White};
+    sf::Color endColor{255, 255, 255, 0};
+};
+
+/// Many short lived particles, such as sparks, smoke or thrust, drawn as one
+/// sf::VertexArray of squares.  The particles live in a fixed capacity pool
+/// of separate arrays, (one per attribute), so updating them is a few tight
+/// loops the compiler can vectorise.  Once the pool is full, new particles are
+/// dropped until old ones die.  Large pools are updated in chunks across the
+/// ThreadPool of the Context given to setContext().
+///
+/// Particles are simulated in the local coordinates of this entity, so they
+/// follow it around.  For trails, leave the entity still and move the
+/// emitter instead.
+/// @see ParticleEmitter
+class ParticleEntity : public CompuBrite::SFML::IEntity
+{
+public:
+    /// Construct an empty pool.
+    /// @param capacity The largest number of particles alive at once.
+    /// @param emitter How to make new particles.
+    /// @param zOrder The zOrder to use.
+    explicit ParticleEntity(std::size_t capacity, const ParticleEmitter &emitter = ParticleEmitter(),
+                            int zOrder = 0);
+
+    virtual ~ParticleEntity() = default;
+
+    /// Change how new particles are made.  Particles alive are left as they
+    /// are.
+    void setEmitter(const ParticleEmitter &emitter);
+
+    /// @return How new particles are made.
+    const ParticleEmitter &getEmitter() const    { return emitter_; }
+
+    /// Start or stop emitting particles at the rate of the emitter.
+    void setEmitting(bool emitting);
+
+    /// @return true if particles are emitted on each update.
+    bool isEmitting() const                      { return emitting_; }
+
+    /// Emit the given number of particles at once.
+    void burst(std::size_t count);
+
+    /// Remove every particle.
+    void clear();
+
+    /// Set the acceleration applied to every particle, such as gravity.
+    void setAcceleration(const sf::Vector2f &acceleration);
+
+    /// @return The acceleration applied to every particle.
+    const sf::Vector2f &getAcceleration() const  { return acceleration_; }
+
+    /// Set the texture stretched over each particle, or nullptr for plain
+    /// squares.  The texture is not owned.
+    void setTexture(const sf::Texture *texture);
+
+    /// @return The texture of the particles, or nullptr.
+    const sf::Texture *getTexture() const        { return texture_; }
+
+    /// Set the blend mode used to draw the particles, such as sf::BlendAdd.
+    void setBlendMode(const sf::BlendMode &mode);
+
+    /// @return The blend mode used to draw the particles.
+    const sf::BlendMode &getBlendMode() const    { return blend_; }
+
+    /// Split large updates across the ThreadPool of the given Context.
+    /// @param context The Context providing the ThreadPool, or nullptr to
+    /// update on the calling thread only.
+    void setContext(Context *context);
+
+    /// @return The number of particles alive.
+    std::size_t getCount() const                 { return count_; }
+
+    /// @return The largest number of particles alive at once.
+    std::size_t getCapacity() const              { return capacity_; }
+
+    /// @return The bounds of the particles alive, as of the last update.
+    sf::FloatRect getLocalBounds() const override;
+
+protected:
+    /// Age, move and emit the particles, then rebuild the vertices.
+    void updateThis(sf::Time dt) override;
+
+    /// Draw every particle with a single draw call.
+    void drawThis(sf::RenderTarget &target, sf::RenderStates states) const override;
+
+private:
+    /// Remove the particles which die during the next dt seconds.
+    void reap(float dt);
+
+    /// Add up to count particles, as room allows.
+    void emit(std::size_t count);
+
+    /// Age and move the given range of particles by dt seconds, and write
+    /// their vertices.
+    /// @return The bounds of the range.
+    sf::FloatRect integrate(std::size_t begin, std::size_t end, float dt);
+
+    std::size_t capacity_;
+    std::size_t count_{0};
+    ParticleEmitter emitter_;
+    bool emitting_{true};
+    float pending_{0.0f};                        ///!< Fraction of a particle owed
+    sf::Vector2f acceleration_;
+    const sf::Texture *texture_{nullptr};
+    sf::BlendMode blend_{sf::BlendAlpha};
+    Context *context_{nullptr};
+    std::minstd_rand random_;
+
+    // One array per attribute, all of capacity_ elements.
+    std::vector<float> x_;
+    std::vector<float> y_;
+    std::vector<float> vx_;
+    std::vector<float> vy_;
+    std::vector<float> age_;
+    std::vector<float> life_;
+
+    sf::VertexArray vertices_{sf::Triangles};    ///!< Six per particle
+    std::vector<sf::FloatRect> chunkBounds_;
+    sf::FloatRect bounds_;
+};
+
+} // namespace CompuBrite::SFML
+
+#endif // COMPUBRITE_SFML_PARTICLEENTITY_H
@@ -28,34 +28,31 @@
 #define COMPUBRITE_SFML_RECTANGLEENTITY_H
 
 #include <CompuBrite/SFML/IShapeEntity.h>
-#include <SFML/Graphics/RectangleShape.hpp>
 
 namespace CompuBrite::SFML {
 
-/// Encapsulate a sf::RectangleShape and bind it to an IEntity object for
-/// drawing and transforming it.
+/// A rectangle, with the same points as sf::RectangleShape, bound to an
+/// IEntity object for drawing and transforming it.
 /// @see IEntity
 /// @see IShapeEntity
 class RectangleEntity : public CompuBrite::SFML::IShapeEntity
 {
 public:
-    /// Construct the sf::RectangleShape object.
-    /// @param size The size of the RectangleShape object.
+    /// Construct the rectangle.
+    /// @param size The size of the rectangle.
     RectangleEntity(const sf::Vector2f &size = sf::Vector2f(0.0f, 0.0f));
 
-    /// Set a new size for the sf::RectangleShape.  This just delegates to
-    /// sf::RectangleShape::setSize()
+    /// Set a new size for the rectangle.
     /// @param size The new size for the rectangle.
     void setSize(const sf::Vector2f &size);
 
-    /// Get the size of the sf::RectangleShape object.  Deletegates to
-    /// sf::RectangleShape::getSize()
+    /// Get the size of the rectangle.
     const sf::Vector2f &getSize() const;
 
 protected:
 
 private:
-    sf::RectangleShape rectangle_;
+    sf::Vector2f size_;
 };
 
 } // namespace CompuBrite::SFML
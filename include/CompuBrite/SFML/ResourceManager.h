@@ -27,11 +27,14 @@
 #ifndef COMPUBRITE_SMFL_RESOURCEMANAGER_H
 #define COMPUBRITE_SMFL_RESOURCEMANAGER_H
 
+#include <cstdint>
 #include <map>
 #include <memory>
+#include <tuple>
 #include <utility>
 
 #include "CompuBrite/CheckPoint.h"
+#include "CompuBrite/SFML/AlphaMask.h"
 
 namespace CompuBrite::SFML {
 
@@ -135,6 +138,40 @@ public:
 
     /// Allow iteration over the resources.
     auto end()                                   { return resources_.end(); }
+
+    /// Build the AlphaMask of part of a resource, and cache it alongside the
+    /// resource.  The resource must provide copyToImage(), (as sf::Texture
+    /// does), and this should be done at load time, since the pixels are
+    /// read back from the graphics card.
+    /// @param id The identifier of the resource.
+    /// @param rect The part of the resource, (e.g. a sprite's texture
+    /// rectangle).
+    /// @param threshold Pixels with at least this alpha are solid.
+    /// @return The AlphaMask, or nullptr if the resource isn't loaded.
+    const AlphaMask *loadMask(const ID &id, const sf::IntRect &rect, std::uint8_t threshold = 128)
+    {
+        auto key = std::make_tuple(id, rect.left, rect.top, rect.width, rect.height);
+        auto found = masks_.find(key);
+        if (found != masks_.end()) {
+            return &found->second;
+        }
+        auto res = find(id);
+        if (!CompuBrite::CheckPoint::expect(CBI_HERE, res, "Resource not found!")) {
+            return nullptr;
+        }
+        auto inserted = masks_.emplace(key, AlphaMask(res->copyToImage(), rect, threshold));
+        return &inserted.first->second;
+    }
+
+    /// Get an AlphaMask cached by loadMask().
+    /// @param id The identifier of the resource.
+    /// @param rect The part of the resource.
+    /// @return The AlphaMask, or nullptr if it hasn't been loaded.
+    const AlphaMask *getMask(const ID &id, const sf::IntRect &rect) const
+    {
+        auto found = masks_.find(std::make_tuple(id, rect.left, rect.top, rect.width, rect.height));
+        return found == masks_.end() ? nullptr : &found->second;
+    }
 
 private:
     /// Find the given resource if it exists.
@@ -151,6 +188,7 @@ private:
 
 private:
     std::map<ID, Ptr> resources_;
+    std::map<std::tuple<ID, int, int, int, int>, AlphaMask> masks_;
 };
 
 } // namespace CompuBrite::SFML
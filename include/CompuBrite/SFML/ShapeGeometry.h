@@ -0,0 +1,103 @@
+/**
+ * The MIT License (MIT)
+ *
+ * @copyright
+ * Copyright (c) 2020 Rich Newman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @file
+ * @brief Interface for ShapeGeometry
+*/
+#ifndef COMPUBRITE_SFML_SHAPEGEOMETRY_H
+#define COMPUBRITE_SFML_SHAPEGEOMETRY_H
+
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/Graphics/Vertex.hpp>
+#include <SFML/System/Vector2.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace CompuBrite::SFML {
+
+/// The immutable, tessellated geometry of a shape: its points, the triangles
+/// of its fill and of its outline, and its bounds.  Geometry is shared by
+/// every shape with the same points and outline thickness, so a thousand
+/// identical circles hold a single copy of it.  Vertices hold positions in
+/// local coordinates only; the fill texture coordinates are normalized over
+/// the inside bounds, and colours are left to each instance.
+/// @see IShapeEntity
+class ShapeGeometry
+{
+public:
+    using Ptr = std::shared_ptr<const ShapeGeometry>;
+    using Points = std::vector<sf::Vector2f>;
+    using Vertices = std::vector<sf::Vertex>;
+
+    /// Get the geometry for the given points and outline thickness, making
+    /// it only if no shape currently uses it.
+    /// @param points The points of the convex shape, in order.
+    /// @param outlineThickness The thickness of the outline, (may be 0).
+    /// @return The shared geometry.
+    static Ptr share(const Points &points, float outlineThickness);
+
+    /// @return The number of distinct geometries currently in use.
+    static std::size_t getSharedCount();
+
+    /// @return The points of the shape.
+    const Points &getPoints() const              { return points_; }
+
+    /// @return The triangles of the fill, (sf::Triangles).
+    const Vertices &getFill() const              { return fill_; }
+
+    /// @return The triangles of the outline, (sf::Triangles).
+    const Vertices &getOutline() const           { return outline_; }
+
+    /// @return The thickness of the outline.
+    float getOutlineThickness() const            { return thickness_; }
+
+    /// @return The bounds of the fill.
+    const sf::FloatRect &getInsideBounds() const { return insideBounds_; }
+
+    /// @return The bounds of the fill and the outline.
+    const sf::FloatRect &getBounds() const       { return bounds_; }
+
+    ShapeGeometry(const ShapeGeometry&) = delete;
+    ShapeGeometry& operator=(const ShapeGeometry&) = delete;
+
+private:
+    ShapeGeometry(const Points &points, float outlineThickness);
+
+    /// Tessellate the fill, as a fan around the center of the inside bounds.
+    void makeFill();
+
+    /// Tessellate the outline, mitering the corners the way sf::Shape does.
+    void makeOutline();
+
+    Points points_;
+    float thickness_;
+    Vertices fill_;
+    Vertices outline_;
+    sf::FloatRect insideBounds_;
+    sf::FloatRect bounds_;
+};
+
+} // namespace CompuBrite::SFML
+
+#endif // COMPUBRITE_SFML_SHAPEGEOMETRY_H
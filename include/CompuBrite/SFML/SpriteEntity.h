@@ -28,12 +28,21 @@
 #define COMPUBRITE_SFML_SPRITEENTITY_H
 
 #include <CompuBrite/SFML/IEntity.h>
+#include <CompuBrite/SFML/IBatchable.h>
+#include <CompuBrite/SFML/AlphaMask.h>
 #include <SFML/Graphics/Sprite.hpp>
+#include <SFML/Graphics/BlendMode.hpp>
+#include <SFML/Graphics/Vertex.hpp>
+
+#include <vector>
 
 namespace CompuBrite::SFML {
 
+struct AtlasEntry;
+
 /// Encapsulates sf::Sprite into the IEntity framework.
-class SpriteEntity : public CompuBrite::SFML::IEntity
+class SpriteEntity : public CompuBrite::SFML::IEntity,
+                     public CompuBrite::SFML::IBatchable
 {
 public:
     /// Construct an empty sf::Sprite.
@@ -57,6 +66,12 @@ public:
     /// Also provide zOrder
     SpriteEntity(int zOrder, const sf::Texture &texture, const sf::IntRect &rectangle);
 
+    /// @override
+    /// Construct a sf::Sprite object from an image packed in a TextureAtlas.
+    /// @param entry The entry of the image, from TextureAtlas::get().
+    /// @param zOrder The zOrder to use.
+    explicit SpriteEntity(const AtlasEntry &entry, int zOrder = 0);
+
     virtual ~SpriteEntity() = default;
 
     /// @return the Axis-Aligned Boundary Box for this Sprite.
@@ -82,12 +97,45 @@ public:
     /// Get the sprite's color.  Delegates to sf::Sprite::getColor().
     const sf::Color &getColor() const;
 
+    /// Set the blend mode used to draw this sprite.
+    void setBlendMode(const sf::BlendMode &mode);
+
+    /// @return The blend mode used to draw this sprite.
+    const sf::BlendMode &getBlendMode() const;
+
+    /// @return true if the sprite has a texture.
+    bool isBatchable() const override;
+
+    /// @return The texture of the sprite.
+    const sf::Texture *getBatchTexture() const override;
+
+    /// @return The blend mode of the sprite.
+    sf::BlendMode getBatchBlendMode() const override;
+
+    /// Append the two triangles covering this sprite to vertices, with their
+    /// positions transformed by the given transform.  DrawingSystem uses
+    /// this to draw all sprites sharing a texture and blend mode at once.
+    /// @param vertices Where to append the six vertices.
+    /// @param transform The transform to apply, usually the one of this
+    /// IEntity combined with the one of the target.
+    void appendTriangles(std::vector<sf::Vertex> &vertices, const sf::Transform &transform) const override;
+
+    /// Set the mask of the solid pixels of the texture rectangle, used by
+    /// CollisionSystem::PIXEL.  The mask is not owned by the sprite.
+    /// @see ResourceManager::loadMask
+    void setAlphaMask(const AlphaMask *mask);
+
+    /// @return The mask of the solid pixels, or nullptr if there is none.
+    const AlphaMask *getAlphaMask() const;
+
 protected:
     /// Draw this sprite.  Delegates to sf::Sprite::draw().
     void drawThis(sf::RenderTarget &target, sf::RenderStates states) const override;
 
 protected:
     sf::Sprite sprite_;
+    sf::BlendMode blend_{sf::BlendAlpha};
+    const AlphaMask *mask_{nullptr};
 };
 
 } // namespace CompuBrite::SFML
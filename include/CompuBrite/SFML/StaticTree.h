@@ -0,0 +1,163 @@
+/**
+ * The MIT License (MIT)
+ *
+ * @copyright
+ * Copyright (c) 2020 Rich Newman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @file
+ * @brief Interface for StaticTree
+*/
+
+#ifndef COMPUBRITE_SFML_STATICTREE_H
+#define COMPUBRITE_SFML_STATICTREE_H
+
+#include <CompuBrite/SFML/DynamicTree.h>
+
+#include <SFML/System/Vector2.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace CompuBrite::SFML {
+
+/// An immutable bounding volume hierarchy for objects which never move, (such
+/// as level geometry).  It is built in one pass from the full set of boxes by
+/// recursively splitting them at the median, and stored depth first in a
+/// single array.  Each node knows where its subtree ends, so it is walked
+/// without a stack.  Changing anything means building it again.
+/// @see DynamicTree, CollisionSystem
+class StaticTree
+{
+public:
+    using AABB = DynamicTree::AABB;
+
+    /// An object to be stored in the tree.
+    struct Item
+    {
+        AABB          aabb;                ///!< Tight bounds
+        std::uint32_t categories;          ///!< See query()
+        std::size_t   index;               ///!< Caller defined, reported by queries
+    };
+
+    /// Construct an empty tree.
+    StaticTree() = default;
+    ~StaticTree() = default;
+
+    /// Replace the contents of the tree.
+    /// @param items Every object the tree is to hold.
+    void build(std::vector<Item> items);
+
+    /// Remove everything from the tree.
+    void clear();
+
+    /// @return true if the tree holds nothing.
+    bool empty() const                           { return items_.empty(); }
+
+    /// Report every Item whose box overlaps the given box, and which shares a
+    /// category bit with the given mask.
+    /// @tparam Callback Callable as bool(std::size_t index), where index is
+    /// the Item's index.  Return false from the callback to stop the query
+    /// early.
+    /// @param aabb The box to query against.
+    /// @param mask Only items with one of these category bits are reported.
+    /// @param callback Called for each overlapping Item.
+    template<typename Callback>
+    void query(const AABB &aabb, std::uint32_t mask, Callback &&callback) const
+    {
+        std::size_t index = 0;
+        while (index < nodes_.size()) {
+            const auto &node = nodes_[index];
+            if (!(node.categories & mask) || !node.aabb.overlaps(aabb)) {
+                index = node.skip;
+                continue;
+            }
+            for (auto item = node.first; item != node.first + node.count; ++item) {
+                const auto &entry = items_[item];
+                if ((entry.categories & mask) && entry.aabb.overlaps(aabb) &&
+                    !callback(entry.index)) {
+                    return;
+                }
+            }
+            ++index;
+        }
+    }
+
+    /// Cast a ray through the tree, reporting every Item whose box it hits.
+    /// @tparam Callback Callable as float(std::size_t index, float maxFraction).
+    /// Return the fraction of the ray at which the Item's object was hit, or
+    /// maxFraction if it wasn't.  Returning 0 ends the raycast.
+    /// @param from The start of the ray.
+    /// @param to The end of the ray.
+    /// @param mask Only items with one of these category bits are reported.
+    /// @param callback Called for each Item hit.
+    /// @see DynamicTree::raycast
+    template<typename Callback>
+    void raycast(const sf::Vector2f &from, const sf::Vector2f &to, std::uint32_t mask,
+                 Callback &&callback) const
+    {
+        const auto direction = to - from;
+        auto maxFraction = 1.0f;
+        std::size_t index = 0;
+        while (index < nodes_.size()) {
+            const auto &node = nodes_[index];
+            float fraction;
+            if (!(node.categories & mask) ||
+                !node.aabb.raycast(from, direction, maxFraction, fraction)) {
+                index = node.skip;
+                continue;
+            }
+            for (auto item = node.first; item != node.first + node.count; ++item) {
+                const auto &entry = items_[item];
+                if (!(entry.categories & mask) ||
+                    !entry.aabb.raycast(from, direction, maxFraction, fraction)) {
+                    continue;
+                }
+                const auto value = callback(entry.index, maxFraction);
+                if (value == 0.0f) {
+                    return;
+                }
+                maxFraction = std::min(maxFraction, value);
+            }
+            ++index;
+        }
+    }
+
+private:
+    /// A node of the tree.  The first child of an internal node follows it,
+    /// so only the end of the subtree needs to be stored.
+    struct Node
+    {
+        AABB          aabb;
+        std::uint32_t categories;          ///!< Union of the items below
+        std::size_t   first;               ///!< First of a leaf's items
+        std::size_t   count;               ///!< Number of items, 0 if internal
+        std::size_t   skip;                ///!< The node after this subtree
+    };
+
+    /// Build the subtree for items [begin, end).
+    void build(std::size_t begin, std::size_t end);
+
+    std::vector<Node> nodes_;
+    std::vector<Item> items_;
+};
+
+} // namespace CompuBrite::SFML
+
+#endif // COMPUBRITE_SFML_STATICTREE_H
@@ -0,0 +1,77 @@
+/**
+ * The MIT License (MIT)
+ *
+ * @copyright
+ * Copyright (c) 2020 Rich Newman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @file
+ * @brief Interface for TaskBatch
+*/
+
+#ifndef COMPUBRITE_SFML_TASKBATCH_H
+#define COMPUBRITE_SFML_TASKBATCH_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+namespace CompuBrite::SFML {
+
+/// Shares a batch of chunks between the calling thread and the ThreadPool.
+/// Chunks are claimed rather than assigned, so the batch completes even if no
+/// pool thread is free to help.  A pool thread which starts after every chunk
+/// has been claimed simply returns.  Keep it in a std::shared_ptr captured by
+/// the tasks, since they may start after the caller is done waiting.
+struct TaskBatch
+{
+    explicit TaskBatch(std::size_t chunks) :
+        chunks(chunks)
+    { }
+
+    /// Claim and run chunks until there are none left.
+    template<typename Work>
+    void run(Work &&work)
+    {
+        for (auto chunk = next++; chunk < chunks; chunk = next++) {
+            work(chunk);
+            std::unique_lock<std::mutex> lock(mutex);
+            if (++done == chunks) {
+                finished.notify_all();
+            }
+        }
+    }
+
+    /// Wait for every chunk to have been run.
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [this] { return done == chunks; });
+    }
+
+    const std::size_t        chunks;
+    std::atomic<std::size_t> next{0};
+    std::size_t              done{0};
+    std::mutex               mutex;
+    std::condition_variable  finished;
+};
+
+} // namespace CompuBrite::SFML
+
+#endif // COMPUBRITE_SFML_TASKBATCH_H
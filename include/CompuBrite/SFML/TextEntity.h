@@ -50,17 +50,28 @@ public:
     /// @return the Axis-Aligned Boundary Box for this Text object.
     sf::FloatRect getLocalBounds() const override;
 
+    /// Set the string shown.  Does nothing if the string doesn't change, so
+    /// sf::Text is not laid out again.
+    void setString(const sf::String &string);
+
     /// @name Delegation
     /// @{
-    void setString(const sf::String &string)     { text_.setString(string); }
-    void setFont(const sf::Font &font)           { text_.setFont(font); }
-    void setCharacterSize(unsigned int size)     { text_.setCharacterSize(size); }
-    void setLineSpacing(float spacing)           { text_.setLineSpacing(spacing); }
-    void setLetterSpacing(float spacing)         { text_.setLetterSpacing(spacing); }
-    void setStyle(sf::Uint32 style)              { text_.setStyle(style); }
-    void setFillColor(const sf::Color &color)    { text_.setFillColor(color); }
-    void setOutlineColor(const sf::Color &color) { text_.setOutlineColor(color); }
-    void setOutlineThickness(float thickness)    { text_.setOutlineThickness(thickness); }
+    void setFont(const sf::Font &font)
+                                                 { text_.setFont(font); invalidate(); }
+    void setCharacterSize(unsigned int size)
+                                                 { text_.setCharacterSize(size); invalidate(); }
+    void setLineSpacing(float spacing)
+                                                 { text_.setLineSpacing(spacing); invalidate(); }
+    void setLetterSpacing(float spacing)
+                                                 { text_.setLetterSpacing(spacing); invalidate(); }
+    void setStyle(sf::Uint32 style)
+                                                 { text_.setStyle(style); invalidate(); }
+    void setFillColor(const sf::Color &color)
+                                                 { text_.setFillColor(color); invalidate(); }
+    void setOutlineColor(const sf::Color &color)
+                                                 { text_.setOutlineColor(color); invalidate(); }
+    void setOutlineThickness(float thickness)
+                                                 { text_.setOutlineThickness(thickness); invalidate(); }
     const sf::String getString() const           { return text_.getString(); }
     const sf::Font *getFont() const              { return text_.getFont(); }
     unsigned int getCharacterSize() const        { return text_.getCharacterSize(); }
@@ -78,15 +89,15 @@ public:
     void startBlinking(float rate);
 
     /// Stop blinking, just draw the text.
-    void stopBlinking()                          { _blink = false; _draw = true; }
+    void stopBlinking()                          { _blink = false; _draw = true; invalidate(); }
 
     /// Hide the text, don't show it.
     /// Also turns off blinking.
-    void hide()                                  { _blink = false; _draw = false;}
+    void hide()                                  { _blink = false; _draw = false; invalidate(); }
 
     /// Show the text without blinking.  Blinking can be restarted by calling
     /// startBlinking.
-    void show()                                  { _blink = false; _draw = true; }
+    void show()                                  { _blink = false; _draw = true; invalidate(); }
     /// @}
 protected:
     /// Draw this sf::Text object
@@ -0,0 +1,241 @@
+/**
+ * The MIT License (MIT)
+ *
+ * @copyright
+ * Copyright (c) 2020 Rich Newman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @file
+ * @brief Interface for TextureAtlas
+*/
+#ifndef COMPUBRITE_SFML_TEXTUREATLAS_H
+#define COMPUBRITE_SFML_TEXTUREATLAS_H
+
+#include <SFML/Graphics/Image.hpp>
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/Graphics/Texture.hpp>
+
+#include "CompuBrite/CheckPoint.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace CompuBrite::SFML {
+
+/// Packs rectangles into a fixed size area with the skyline bottom-left
+/// heuristic.  The skyline is the top edge of everything packed so far, kept
+/// as a list of horizontal segments; a rectangle goes where it ends lowest.
+class SkylinePacker
+{
+public:
+    /// Construct an empty packer.
+    /// @param width The width of the area to pack.
+    /// @param height The height of the area to pack.
+    SkylinePacker(unsigned width, unsigned height);
+
+    /// Find room for a rectangle and reserve it.
+    /// @param width The width of the rectangle.
+    /// @param height The height of the rectangle.
+    /// @param rect Receives the position of the rectangle.
+    /// @return false if there is no room left for the rectangle.
+    bool insert(unsigned width, unsigned height, sf::IntRect &rect);
+
+    /// Forget everything packed so far.
+    void clear();
+
+private:
+    struct Segment
+    {
+        unsigned x;
+        unsigned y;
+        unsigned width;
+    };
+
+    /// @return true if a rectangle fits with its left edge on the given
+    /// segment, with y receiving the height it would rest at.
+    bool fit(std::size_t index, unsigned width, unsigned height, unsigned &y) const;
+
+    unsigned width_;
+    unsigned height_;
+    std::vector<Segment> skyline_;
+};
+
+/// Where an image lives in a TextureAtlas.
+struct AtlasEntry
+{
+    const sf::Texture *texture{nullptr};    ///!< The page holding the image
+    sf::IntRect rect;                       ///!< The image within the page
+    std::size_t page{0};                    ///!< Index of the page
+};
+
+/// Packs many images into a few large textures, (pages), so that sprites
+/// using them share a texture and can be batched by DrawingSystem.
+/// Images are added by identifier, then packed and uploaded by build(),
+/// after which each identifier maps to an AtlasEntry.  More images may be
+/// added and built later; they go into the room left in existing pages
+/// before new pages are made.
+/// @tparam ID The type of the identifier to use.
+template<typename ID>
+class TextureAtlas
+{
+public:
+    using Self = TextureAtlas<ID>;
+
+    /// Construct an empty atlas.
+    /// @param pageSize The width and height of each page, limited to the
+    /// largest texture supported by the graphics card.
+    /// @param padding Empty pixels left between images, to keep smoothing
+    /// from bleeding neighbours into each other.
+    explicit TextureAtlas(unsigned pageSize = 2048, unsigned padding = 1) :
+        pageSize_(std::min(pageSize, sf::Texture::getMaximumSize())),
+        padding_(padding)
+    {
+    }
+
+    TextureAtlas(const Self&) = delete;
+    TextureAtlas(Self&&) = default;
+    ~TextureAtlas() = default;
+
+    Self& operator=(const Self&) = delete;
+    Self& operator=(Self&&) = default;
+
+    /// Queue an image for the next build().
+    /// @param id The identifier to associate with the image.
+    /// @param image The image to pack.
+    /// @return false if the identifier is already used, or the image is
+    /// larger than a page.
+    bool add(const ID &id, const sf::Image &image)
+    {
+        if (entries_.count(id) || pending_.count(id)) {
+            CompuBrite::CheckPoint::hit(CBI_HERE, "Atlas entry already added.");
+            return false;
+        }
+        auto size = image.getSize();
+        if (size.x + padding_ > pageSize_ || size.y + padding_ > pageSize_) {
+            CompuBrite::CheckPoint::hit(CBI_HERE, "Image larger than an atlas page.");
+            return false;
+        }
+        pending_[id] = image;
+        return true;
+    }
+
+    /// Load an image from the given file and queue it for the next build().
+    /// @param id The identifier to associate with the image.
+    /// @param filename The filename to load from.
+    /// @return false if the image could not be added.
+    bool load(const ID &id, const std::string &filename)
+    {
+        sf::Image image;
+        if (!image.loadFromFile(filename)) {
+            throw std::runtime_error("failed to load file: " + filename);
+        }
+        return add(id, image);
+    }
+
+    /// Pack all queued images, tallest first, and upload them to the pages.
+    void build()
+    {
+        std::vector<typename Pending::iterator> order;
+        for (auto it = pending_.begin(); it != pending_.end(); ++it) {
+            order.push_back(it);
+        }
+        std::stable_sort(order.begin(), order.end(), [](auto lhs, auto rhs) {
+            auto l = lhs->second.getSize();
+            auto r = rhs->second.getSize();
+            return l.y != r.y ? l.y > r.y : l.x > r.x;
+        });
+        for (auto it : order) {
+            auto &image = it->second;
+            auto size = image.getSize();
+            AtlasEntry entry;
+            for (; entry.page < pages_.size(); ++entry.page) {
+                if (pages_[entry.page].packer.insert(size.x + padding_, size.y + padding_, entry.rect)) {
+                    break;
+                }
+            }
+            if (entry.page == pages_.size()) {
+                addPage().packer.insert(size.x + padding_, size.y + padding_, entry.rect);
+            }
+            auto &page = pages_[entry.page];
+            page.texture->update(image, entry.rect.left, entry.rect.top);
+            entry.rect.width = size.x;
+            entry.rect.height = size.y;
+            entry.texture = page.texture.get();
+            entries_[it->first] = entry;
+        }
+        pending_.clear();
+    }
+
+    /// @return true if the given identifier has been built into the atlas.
+    bool contains(const ID &id) const                { return entries_.count(id) != 0; }
+
+    /// Get where an image was packed.
+    /// @param id The identifier of the image.
+    /// @return The AtlasEntry of the image, or an empty one if the identifier
+    /// has not been built.
+    const AtlasEntry& get(const ID &id) const
+    {
+        static const AtlasEntry none;
+        auto found = entries_.find(id);
+        if (!CompuBrite::CheckPoint::expect(CBI_HERE, found != entries_.end(), "Atlas entry not found!")) {
+            return none;
+        }
+        return found->second;
+    }
+
+    /// @return The number of pages in this atlas.
+    std::size_t getPageCount() const                 { return pages_.size(); }
+
+    /// @return The texture of the given page.
+    const sf::Texture& getPage(std::size_t page) const { return *pages_.at(page).texture; }
+
+private:
+    using Pending = std::map<ID, sf::Image>;
+
+    struct Page
+    {
+        std::unique_ptr<sf::Texture> texture;
+        SkylinePacker packer;
+    };
+
+    /// Create a new, empty, page.
+    Page& addPage()
+    {
+        auto texture = std::make_unique<sf::Texture>();
+        if (!texture->create(pageSize_, pageSize_)) {
+            throw std::runtime_error("failed to create atlas page");
+        }
+        pages_.push_back(Page{std::move(texture), SkylinePacker(pageSize_, pageSize_)});
+        return pages_.back();
+    }
+
+    unsigned pageSize_;
+    unsigned padding_;
+    std::vector<Page> pages_;
+    std::map<ID, AtlasEntry> entries_;
+    Pending pending_;
+};
+
+} // namespace CompuBrite::SFML
+
+#endif // COMPUBRITE_SFML_TEXTUREATLAS_H
@@ -0,0 +1,132 @@
+/**
+ * The MIT License (MIT)
+ *
+ * @copyright
+ * Copyright (c) 2020 Rich Newman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @file
+ * @brief Interface for TileMapEntity
+*/
+
+#ifndef COMPUBRITE_SFML_TILEMAPENTITY_H
+#define COMPUBRITE_SFML_TILEMAPENTITY_H
+
+#include <CompuBrite/SFML/IEntity.h>
+
+#include <SFML/Graphics/Texture.hpp>
+#include <SFML/Graphics/VertexArray.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace CompuBrite::SFML {
+
+/// A grid of tiles from a single tileset texture, drawn as one entity
+/// instead of one SpriteEntity per tile.  Tiles are stored as 16 bit indices
+/// into the tileset, numbered left to right then top to bottom.  The map is
+/// split into chunks of ChunkSize x ChunkSize tiles, each baked into its own
+/// sf::VertexArray the first time it is drawn.  Only the chunks intersecting
+/// the view of the target are drawn, and a chunk is baked again only when
+/// one of its tiles changes.
+class TileMapEntity : public CompuBrite::SFML::IEntity
+{
+public:
+    using Tile = std::uint16_t;
+
+    /// A tile which draws nothing.
+    static constexpr Tile Empty = 0xffff;
+
+    /// The width and height of a chunk, in tiles.
+    static constexpr unsigned ChunkSize = 16;
+
+    /// Construct a map filled with Empty tiles.
+    /// @param tileset The texture holding the tiles, which must outlive this
+    /// entity.
+    /// @param tileSize The size of a tile, in pixels, both in the tileset and
+    /// on screen.
+    /// @param width The width of the map, in tiles.
+    /// @param height The height of the map, in tiles.
+    /// @param zOrder The zOrder to use.
+    TileMapEntity(const sf::Texture &tileset, const sf::Vector2u &tileSize,
+                  unsigned width, unsigned height, int zOrder = 0);
+
+    virtual ~TileMapEntity() = default;
+
+    /// Change one tile.  Out of range positions are ignored.
+    /// @param x The column of the tile.
+    /// @param y The row of the tile.
+    /// @param tile The index of the tile in the tileset, or Empty.
+    void setTile(unsigned x, unsigned y, Tile tile);
+
+    /// @return The tile at the given position, or Empty if it is out of
+    /// range.
+    Tile getTile(unsigned x, unsigned y) const;
+
+    /// Replace every tile.
+    /// @param tiles The tiles, row by row.  Missing tiles are Empty, and
+    /// extra ones are ignored.
+    void setTiles(const std::vector<Tile> &tiles);
+
+    /// Set every tile to the same one.
+    void fill(Tile tile);
+
+    /// @return The size of the map, in tiles.
+    sf::Vector2u getMapSize() const              { return {width_, height_}; }
+
+    /// @return The size of a tile, in pixels.
+    const sf::Vector2u &getTileSize() const      { return tileSize_; }
+
+    /// @return The number of chunks drawn by the last draw.
+    std::size_t getDrawnChunks() const           { return drawn_; }
+
+    /// @return The bounds of the whole map.
+    sf::FloatRect getLocalBounds() const override;
+
+protected:
+    /// Bake the chunks which need it, then draw those in view.
+    void drawThis(sf::RenderTarget &target, sf::RenderStates states) const override;
+
+private:
+    struct Chunk
+    {
+        sf::VertexArray vertices{sf::Triangles};
+        std::atomic<bool> dirty{true};
+    };
+
+    /// Mark the chunk holding the given tile for baking.
+    void touch(unsigned x, unsigned y);
+
+    /// Rebuild the vertices of a chunk from its tiles.
+    void bake(unsigned chunkX, unsigned chunkY) const;
+
+    const sf::Texture *tileset_;
+    sf::Vector2u tileSize_;
+    unsigned width_;
+    unsigned height_;
+    unsigned chunksX_;
+    unsigned chunksY_;
+    std::vector<Tile> tiles_;
+    mutable std::vector<Chunk> chunks_;
+    mutable std::size_t drawn_{0};
+};
+
+} // namespace CompuBrite::SFML
+
+#endif // COMPUBRITE_SFML_TILEMAPENTITY_H
@@ -0,0 +1,113 @@
+/**
+ * The MIT License (MIT)
+ *
+ * @copyright
+ * Copyright (c) 2020 Rich Newman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @file
+ * @brief Interface for TransformJournal
+*/
+#ifndef COMPUBRITE_SFML_TRANSFORMJOURNAL_H
+#define COMPUBRITE_SFML_TRANSFORMJOURNAL_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace CompuBrite::SFML {
+
+class IEntity;
+
+/// Record of the IEntity objects whose sf::Transformable state changed during
+/// a frame.  IEntity appends itself the first time its position, rotation,
+/// scale or origin changes in a frame, so each entity appears at most once
+/// per frame no matter how often it is moved.  Context calls advance() after
+/// every update tick; the entities recorded during that tick are then
+/// available from forEachChanged() until the next advance().  A system which
+/// moves entities from the ThreadPool must wait for those tasks before its
+/// update() returns, as MovementSystem does, or the moves land in the next
+/// frame.
+///
+/// Only the entity whose own transform changed is recorded.  Its children
+/// move along with it without being recorded, so a system interested in
+/// global transforms must also consider the descendants of each entry.
+/// @see IEntity::journal()
+class TransformJournal
+{
+public:
+    using Entities = std::vector<IEntity*>;
+    using Frame = std::uint32_t;
+
+    TransformJournal() = default;
+
+    /// Record that the transform of the given IEntity changed during the
+    /// current frame.  Called by IEntity, it is safe to call from any thread
+    /// and cheap once the entity has already been recorded in this frame.
+    /// @param entity The IEntity whose transform changed.
+    void record(IEntity &entity);
+
+    /// Remove every reference to the given IEntity.  Called when an IEntity
+    /// is destroyed so the journal never hands out dangling pointers.
+    /// @param entity The IEntity to forget.
+    void forget(IEntity &entity);
+
+    /// Close the current frame.  Entities recorded since the last call
+    /// become the changed set, and recording starts over.
+    void advance();
+
+    /// Visit the IEntity objects whose transform changed during the last
+    /// completed frame, in the order they first changed.  The journal is
+    /// locked meanwhile, so visit must not move any IEntity.
+    /// @param visit Called with an IEntity& for each entity.
+    template<typename Visit>
+    void forEachChanged(Visit &&visit) const
+    {
+        auto l = lock();
+        for (auto entity : changed_) {
+            visit(*entity);
+        }
+    }
+
+    /// @return true if the transform of the given IEntity, or of any of its
+    /// ancestors, was recorded in the given frame or a later one.  Lets a
+    /// system which remembers frame() ask whether a global transform may have
+    /// changed since, without keeping a copy of it.
+    /// @param entity The IEntity to check.
+    /// @param frame A frame returned by frame().
+    bool changedSince(const IEntity &entity, Frame frame) const;
+
+    /// @return The number of the frame currently being recorded.
+    Frame frame() const                       { return frame_.load(std::memory_order_acquire); }
+
+private:
+    using Mutex = std::mutex;
+    using Lock = std::unique_lock<Mutex>;
+
+    mutable Mutex mutex_;
+    Lock lock() const                         { return Lock(mutex_); }
+
+    std::atomic<Frame> frame_{1};             ///!< Frame being recorded, 0 means never.
+    Entities current_;                        ///!< Entities changed in frame_.
+    Entities changed_;                        ///!< Entities changed in the last frame.
+};
+
+} // namespace CompuBrite::SFML
+
+#endif // COMPUBRITE_SFML_TRANSFORMJOURNAL_H
@@ -7,7 +7,9 @@
 #include "CompuBrite/SFML/DrawingSystem.h"
 #include "CompuBrite/SFML/CollisionSystem.h"
 #include "CompuBrite/SFML/Engine.h"
+#include "CompuBrite/SFML/NumberEntity.h"
 #include "CompuBrite/SFML/Context.h"
+#include "CompuBrite/SFML/ParticleEntity.h"
 #include "CompuBrite/SFML/RectangleEntity.h"
 #include "CompuBrite/SFML/ResourceManager.h"
 #include "CompuBrite/SFML/TextEntity.h"
@@ -74,9 +76,9 @@ class Altitude : public cbisf::ISystem
 {
 public:
     Altitude() :
-        altitude_("", fontManager.get(Fonts::Vera), 15),
-        velocity_("", fontManager.get(Fonts::Vera), 15),
-        gravity_("", fontManager.get(Fonts::Vera), 15),
+        altitude_(fontManager.get(Fonts::Vera), 15, "Alt: ", "", 2, 8),
+        velocity_(fontManager.get(Fonts::Vera), 15, "Vel: ", "m/s", 2, 8),
+        gravity_(fontManager.get(Fonts::Vera), 15, "Gravity: ", " m/s^2", precision_, width_),
         fuel_("", fontManager.get(Fonts::Vera), 15)
     {
         altitude_.setPosition(180.0f, 0.0f);
@@ -96,9 +98,13 @@ private:
     void addProperties(cbisf::IEntity &entity);
 
 private:
-    cbisf::TextEntity altitude_;
-    cbisf::TextEntity velocity_;
-    cbisf::TextEntity gravity_;
+    // The fuel line and the gravity readout share one format.
+    static constexpr int precision_ = 2;
+    static constexpr int width_ = 6;
+
+    cbisf::NumberEntity altitude_;
+    cbisf::NumberEntity velocity_;
+    cbisf::NumberEntity gravity_;
     cbisf::TextEntity fuel_;
     float             maxAlt_ = 0.0f;
 };
@@ -116,12 +122,9 @@ Altitude::update(cbisf::Context &context, sf::Time dt)
         auto &accel = entity->properties.ref<sf::Vector2f>("acceleration");
         auto &fuel = entity->properties.ref<float>("fuel");
         accel = {0.0f, GRAVITY + gravity_modifier};
-        std::ostringstream os;
         auto alt = maxAlt_ - entity->getPosition().y - 10.0f;
         entity->properties.set<float>("altitude", alt);
-        os << std::fixed << "Alt: "
-           << std::setw(8) << std::setprecision(2) << alt;
-        altitude_.setString(os.str());
+        altitude_.setValue(alt);
         entity->properties.set<float>("altitude", alt);
         if (sf::Keyboard::isKeyPressed(sf::Keyboard::Space)) {
             if (fuel > 0.0f) {
@@ -132,14 +135,9 @@ Altitude::update(cbisf::Context &context, sf::Time dt)
                 }
             }
         }
-        os.str("");
-        os << std::fixed << "Vel: "
-           << std::setw(8) << std::setprecision(2)
-           << entity->properties.get<sf::Vector2f>("velocity").y
-           << "m/s";
-        velocity_.setString(os.str());
-        os.str("");
-        os << "Fuel: " << std::setw(6) << std::setprecision(2) << fuel;
+        velocity_.setValue(entity->properties.get<sf::Vector2f>("velocity").y);
+        std::ostringstream os;
+        os << std::fixed << "Fuel: " << std::setw(width_) << std::setprecision(precision_) << fuel;
         fuel_.setString(os.str());
         if (fuel > 10.0f) {
             fuel_.setFillColor(sf::Color::White);
@@ -149,10 +147,7 @@ Altitude::update(cbisf::Context &context, sf::Time dt)
             fuel_.setFillColor(sf::Color::Red);
             fuel_.startBlinking(0.5f);
         }
-        os.str("");
-        os << "Gravity: " << std::setw(6) << std::setprecision(2) <<
-               GRAVITY + gravity_modifier << " m/s^2";
-        gravity_.setString(os.str());
+        gravity_.setValue(GRAVITY + gravity_modifier);
     }
     fuel_.update(dt);
 }
@@ -238,23 +233,59 @@ LandedState::draw(cbisf::Context &target, sf::RenderStates states) const
     return lastDrawn_;
 }
 
-class Thrust : public cbisf::CircleEntity
+class Thrust : public cbisf::ParticleEntity
 {
 public:
-    Thrust() : cbisf::CircleEntity(8.0f, 3) { }
-    using inherited = cbisf::CircleEntity;
+    Thrust();
+    using inherited = cbisf::ParticleEntity;
 
 private:
-    void drawThis(sf::RenderTarget &target, sf::RenderStates states) const override;
+    void updateThis(sf::Time dt) override;
 };
 
+Thrust::Thrust() :
+    inherited(512)
+{
+    cbisf::ParticleEmitter exhaust;
+    exhaust.rate = 300.0f;
+    exhaust.spread = {3.0f, 0.0f};
+    exhaust.direction = 90.0f;
+    exhaust.angle = 30.0f;
+    exhaust.minSpeed = 60.0f;
+    exhaust.maxSpeed = 120.0f;
+    exhaust.minLife = 0.2f;
+    exhaust.maxLife = 0.4f;
+    exhaust.startSize = 3.0f;
+    exhaust.endSize = 1.0f;
+    exhaust.startColor = sf::Color::Yellow;
+    exhaust.endColor = sf::Color(255, 0, 0, 0);
+    setEmitter(exhaust);
+    setBlendMode(sf::BlendAdd);
+}
+
 void
-Thrust::drawThis(sf::RenderTarget &target, sf::RenderStates states) const
+Thrust::updateThis(sf::Time dt)
+{
+    setEmitting(sf::Keyboard::isKeyPressed(sf::Keyboard::Space) &&
+                parent_.load()->properties.get<float>("fuel") > 0.0f);
+    inherited::updateThis(dt);
+}
+
+/// Advance the particles of the entities added to it every update.
+class Particles : public cbisf::ISystem
 {
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Space) &&
-        parent_->properties.get<float>("fuel") > 0.0f) {
-        inherited::drawThis(target, states);
-        //target.draw(circle_, states);
+public:
+    Particles() = default;
+    ~Particles() = default;
+
+    void update(cbisf::Context &context, sf::Time dt) override;
+};
+
+void
+Particles::update(cbisf::Context &context, sf::Time dt)
+{
+    for (auto entity : entities_) {
+        entity->update(dt);
     }
 }
 
@@ -277,9 +308,10 @@ private:
     Thrust                   thrust_;
     cbisf::RectangleEntity   ground_{{width_, 100.0f}};
     cbisf::MovementSystem    ms_;
-    cbisf::CollisionSystem   cs_{cbisf::CollisionSystem::AABB};
+    cbisf::CollisionSystem   cs_{cbisf::CollisionSystem::SAT};
     cbisf::DrawingSystem     ds_;
     Altitude                 alt_;
+    Particles                ps_;
 
     cbisf::State             landingState_;
     InstructionState         iState_;
@@ -298,10 +330,7 @@ Lander::init(cbisf::Engine &engine)
     ship_.properties.add<float>("fuel", maxFuel_);
 
     ship_.addChild(thrust_);
-    thrust_.setFillColor(sf::Color::Red);
-    thrust_.setOrigin(4.0f, 4.0f);
-    thrust_.rotate(180.0f);
-    thrust_.setPosition(14.0f, 25.0f);
+    thrust_.setPosition(10.0f, 20.0f);
 
     ground_.setPosition(0.0f, height_ -10.0f);
     ground_.setFillColor(sf::Color::Red);
@@ -370,6 +399,7 @@ Lander::init(cbisf::Engine &engine)
     cs_.addEntity(ship_);
     cs_.addEntity(ground_);
     alt_.addEntity(ship_);
+    ps_.addEntity(thrust_);
     alt_.acceptSystem(ds_);
     alt_.setMaxAlt(height_ - 10.0f);
 
@@ -377,14 +407,15 @@ Lander::init(cbisf::Engine &engine)
     landingState_.addSystem(ms_);
     landingState_.addSystem(cs_);
     landingState_.addSystem(alt_);
+    landingState_.addSystem(ps_);
     landingState_.addSystem(ds_);
 
-    // Setup collision system
-    cs_.addHandler<cbisf::CircleEntity, cbisf::RectangleEntity>(
-    [this, &engine] (cbisf::CircleEntity &ship, cbisf::RectangleEntity &ground, const sf::FloatRect&) {
-        if (ship.properties.get<float>("altitude") <= 0.0f) {
-            engine.getContext("lander").stack().push(landedState_);
-        }
+    // Setup collision system, the landing is judged once, on touch down.
+    // Tested at the SAT level, so it begins when the hull of the ship meets
+    // the ground, not when their bounds do.
+    cs_.onBegin<cbisf::CircleEntity, cbisf::RectangleEntity>(
+    [this, &engine] (cbisf::CircleEntity &, cbisf::RectangleEntity &, const sf::FloatRect&) {
+        engine.getContext("lander").stack().push(landedState_);
     });
 
     // Push the instruction state.
@@ -0,0 +1,173 @@
+/**
+ * The MIT License (MIT)
+ *
+ * @copyright
+ * Copyright (c) 2020 Rich Newman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @file
+ * @brief Implementation for AlphaMask
+*/
+
+#include "CompuBrite/SFML/AlphaMask.h"
+
+#include <SFML/Graphics/Image.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace CompuBrite::SFML {
+
+/// Bits per word.
+static constexpr int wordBits = 64;
+
+/// @return x / wordBits, rounded down.
+static int
+wordOf(int x)
+{
+    return (x >= 0) ? x / wordBits : -((-x + wordBits - 1) / wordBits);
+}
+
+AlphaMask::AlphaMask(const sf::Image &image, const sf::IntRect &rect, std::uint8_t threshold)
+{
+    // A negative width or height flips the sprite, so the mask is read from
+    // the normalized rectangle and mirrored.
+    const auto flipX = rect.width < 0;
+    const auto flipY = rect.height < 0;
+    const auto normalLeft = flipX ? rect.left + rect.width : rect.left;
+    const auto normalTop = flipY ? rect.top + rect.height : rect.top;
+    const auto size = image.getSize();
+    const auto left = std::max(normalLeft, 0);
+    const auto top = std::max(normalTop, 0);
+    const auto right = std::min(normalLeft + std::abs(rect.width), static_cast<int>(size.x));
+    const auto bottom = std::min(normalTop + std::abs(rect.height), static_cast<int>(size.y));
+    if (right <= left || bottom <= top) {
+        return;
+    }
+
+    width_ = right - left;
+    height_ = bottom - top;
+    words_ = (width_ + wordBits - 1) / wordBits;
+    bits_.assign(words_ * height_, 0);
+
+    // RGBA, so alpha is every fourth byte.
+    const auto pixels = image.getPixelsPtr();
+    for (unsigned y = 0; y < height_; ++y) {
+        const auto source = flipY ? height_ - 1 - y : y;
+        const auto row = pixels + 4 * ((top + source) * size.x + left) + 3;
+        auto bits = &bits_[y * words_];
+        for (unsigned x = 0; x < width_; ++x) {
+            const auto column = flipX ? width_ - 1 - x : x;
+            if (row[4 * column] >= threshold) {
+                bits[x / wordBits] |= std::uint64_t(1) << (x % wordBits);
+            }
+        }
+    }
+}
+
+bool
+AlphaMask::test(int x, int y) const
+{
+    if (x < 0 || y < 0 || x >= static_cast<int>(width_) || y >= static_cast<int>(height_)) {
+        return false;
+    }
+    return (bits_[y * words_ + x / wordBits] >> (x % wordBits)) & 1;
+}
+
+std::uint64_t
+AlphaMask::getBits(int x, int y) const
+{
+    if (y < 0 || y >= static_cast<int>(height_)) {
+        return 0;
+    }
+    const auto index = wordOf(x);
+    const auto shift = x - index * wordBits;
+    if (shift == 0) {
+        return word(index, y);
+    }
+    return (word(index, y) >> shift) | (word(index + 1, y) << (wordBits - shift));
+}
+
+bool
+AlphaMask::overlaps(const sf::Transform &transform, const AlphaMask *other,
+                    const sf::FloatRect &otherRect) const
+{
+    // Only the rows and columns under the other can overlap.
+    const auto region = transform.getInverse().transformRect(otherRect);
+    const auto top = std::max(0, static_cast<int>(std::floor(region.top)));
+    const auto bottom = std::min(static_cast<int>(height_),
+                                 static_cast<int>(std::ceil(region.top + region.height)));
+    const auto left = std::max(0, static_cast<int>(std::floor(region.left)));
+    const auto right = std::min(static_cast<int>(width_),
+                                static_cast<int>(std::ceil(region.left + region.width)));
+    if (bottom <= top || right <= left) {
+        return false;
+    }
+
+    // x' = a x + b y + c, y' = d x + e y + f
+    const auto m = transform.getMatrix();
+    const auto a = m[0], b = m[4], c = m[12];
+    const auto d = m[1], e = m[5], f = m[13];
+    constexpr auto epsilon = 1e-5f;
+
+    if (other && std::abs(a - 1.0f) < epsilon && std::abs(e - 1.0f) < epsilon &&
+        std::abs(b) < epsilon && std::abs(d) < epsilon) {
+        // Only translated, so each word of the other lines up with a shifted
+        // word of this mask.  The centre of pixel x lands in pixel
+        // x + floor(c + 0.5) of the other.
+        const auto dx = static_cast<int>(std::floor(c + 0.5f));
+        const auto dy = static_cast<int>(std::floor(f + 0.5f));
+        for (auto y = top; y < bottom; ++y) {
+            for (auto index = left / wordBits; index <= (right - 1) / wordBits; ++index) {
+                if (word(index, y) & other->getBits(index * wordBits + dx, y + dy)) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // Rotated or scaled, so gather the other's pixels under each word of this
+    // mask into a word of their own.
+    for (auto y = top; y < bottom; ++y) {
+        for (auto index = left / wordBits; index <= (right - 1) / wordBits; ++index) {
+            const auto bits = word(index, y);
+            if (!bits) {
+                continue;
+            }
+            const auto first = std::max(left, index * wordBits);
+            const auto last = std::min(right, (index + 1) * wordBits);
+            auto px = a * (first + 0.5f) + b * (y + 0.5f) + c;
+            auto py = d * (first + 0.5f) + e * (y + 0.5f) + f;
+            std::uint64_t gathered = 0;
+            for (auto x = first; x < last; ++x, px += a, py += d) {
+                const bool solid = other ? other->test(static_cast<int>(std::floor(px)),
+                                                       static_cast<int>(std::floor(py)))
+                                         : otherRect.contains(px, py);
+                gathered |= std::uint64_t(solid) << (x - index * wordBits);
+            }
+            if (bits & gathered) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+} // namespace CompuBrite::SFML
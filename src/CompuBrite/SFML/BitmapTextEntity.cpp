@@ -0,0 +1,165 @@
+/**
+ * The MIT License (MIT)
+ *
+ * @copyright
+ * Copyright (c) 2020 Rich Newman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @file
+ * @brief Implementation for BitmapTextEntity
+*/
+
+#include "CompuBrite/SFML/BitmapTextEntity.h"
+
+#include <SFML/Graphics/RenderTarget.hpp>
+
+#include <algorithm>
+#include <limits>
+
+namespace CompuBrite::SFML {
+
+BitmapTextEntity::BitmapTextEntity(const GlyphAtlas &atlas, std::string_view string, float size) :
+    atlas_(&atlas),
+    string_(string),
+    size_(size > 0.0f ? size : static_cast<float>(atlas.getCharacterSize()))
+{
+    layout();
+}
+
+void
+BitmapTextEntity::setString(std::string_view string)
+{
+    if (string == string_) {
+        return;
+    }
+    string_ = string;
+    layout();
+    invalidate();
+}
+
+void
+BitmapTextEntity::setCharacterSize(float size)
+{
+    size_ = size;
+    layout();
+    invalidate();
+}
+
+void
+BitmapTextEntity::setFillColor(const sf::Color &color)
+{
+    color_ = color;
+    for (auto &vertex : vertices_) {
+        vertex.color = color;
+    }
+    invalidate();
+}
+
+sf::FloatRect
+BitmapTextEntity::getLocalBounds() const
+{
+    return bounds_;
+}
+
+const sf::Texture *
+BitmapTextEntity::getBatchTexture() const
+{
+    return &atlas_->getTexture();
+}
+
+void
+BitmapTextEntity::appendTriangles(std::vector<sf::Vertex> &vertices, const sf::Transform &transform) const
+{
+    for (auto vertex : vertices_) {
+        vertex.position = transform.transformPoint(vertex.position);
+        vertices.push_back(vertex);
+    }
+}
+
+void
+BitmapTextEntity::layout()
+{
+    vertices_.clear();
+    bounds_ = sf::FloatRect();
+    auto scale = size_ / static_cast<float>(atlas_->getCharacterSize());
+    auto lineSpacing = atlas_->getLineSpacing();
+    auto minX = std::numeric_limits<float>::max();
+    auto minY = minX;
+    auto maxX = std::numeric_limits<float>::lowest();
+    auto maxY = maxX;
+
+    // Laid out at the baked size, then scaled.
+    auto penX = 0.0f;
+    auto baseline = static_cast<float>(atlas_->getCharacterSize());
+    std::uint32_t previous = 0;
+    for (auto c : string_) {
+        auto code = static_cast<std::uint32_t>(static_cast<unsigned char>(c));
+        if (code == '\n') {
+            penX = 0.0f;
+            baseline += lineSpacing;
+            previous = 0;
+            continue;
+        }
+        auto glyph = atlas_->getGlyph(code);
+        if (!glyph) {
+            continue;
+        }
+        if (previous) {
+            penX += atlas_->getKerning(previous, code);
+        }
+        previous = code;
+        if (glyph->rect.width > 0) {
+            auto left = (penX + glyph->bounds.left) * scale;
+            auto top = (baseline + glyph->bounds.top) * scale;
+            auto right = left + glyph->bounds.width * scale;
+            auto bottom = top + glyph->bounds.height * scale;
+            auto u1 = static_cast<float>(glyph->rect.left);
+            auto v1 = static_cast<float>(glyph->rect.top);
+            auto u2 = u1 + glyph->rect.width;
+            auto v2 = v1 + glyph->rect.height;
+
+            sf::Vertex quad[4] = {
+                sf::Vertex({left, top}, color_, {u1, v1}),
+                sf::Vertex({right, top}, color_, {u2, v1}),
+                sf::Vertex({left, bottom}, color_, {u1, v2}),
+                sf::Vertex({right, bottom}, color_, {u2, v2}),
+            };
+            vertices_.insert(vertices_.end(), {quad[0], quad[1], quad[2], quad[2], quad[1], quad[3]});
+            minX = std::min(minX, left);
+            minY = std::min(minY, top);
+            maxX = std::max(maxX, right);
+            maxY = std::max(maxY, bottom);
+        }
+        penX += glyph->advance;
+    }
+    if (maxX > minX && maxY > minY) {
+        bounds_ = sf::FloatRect(minX, minY, maxX - minX, maxY - minY);
+    }
+}
+
+void
+BitmapTextEntity::drawThis(sf::RenderTarget &target, sf::RenderStates states) const
+{
+    if (vertices_.empty()) {
+        return;
+    }
+    states.texture = &atlas_->getTexture();
+    target.draw(vertices_.data(), vertices_.size(), sf::Triangles, states);
+}
+
+} // namespace CompuBrite::SFML
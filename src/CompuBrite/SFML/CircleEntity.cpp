@@ -26,30 +26,48 @@
 
 #include "CompuBrite/SFML/CircleEntity.h"
 
+#include <cmath>
+
 namespace CompuBrite::SFML {
 
 CircleEntity::CircleEntity(float radius, std::size_t pointCount) :
-    IShapeEntity(circle_),
-    circle_(radius, pointCount)
+    radius_(radius),
+    pointCount_(pointCount)
 {
+    updatePoints();
 }
 
 void
 CircleEntity::setRadius(float radius)
 {
-    circle_.setRadius(radius);
+    radius_ = radius;
+    updatePoints();
 }
 
 float
 CircleEntity::getRadius() const
 {
-    return circle_.getRadius();
+    return radius_;
 }
 
 void
 CircleEntity::setPointCount(std::size_t count)
 {
-    circle_.setPointCount(count);
+    pointCount_ = count;
+    updatePoints();
+}
+
+void
+CircleEntity::updatePoints()
+{
+    static const float pi = 3.141592654f;
+
+    ShapeGeometry::Points points(pointCount_);
+    for (std::size_t i = 0; i < pointCount_; ++i) {
+        auto angle = i * 2 * pi / pointCount_ - pi / 2;
+        points[i] = sf::Vector2f(radius_ + std::cos(angle) * radius_, radius_ + std::sin(angle) * radius_);
+    }
+    setPoints(points);
 }
 
 } // namespace CompuBrite::SFML
@@ -25,9 +25,20 @@
 */
 
 #include "CompuBrite/SFML/CollisionSystem.h"
+#include "CompuBrite/SFML/Context.h"
+#include "CompuBrite/SFML/CircleEntity.h"
+#include "CompuBrite/SFML/DebugDraw.h"
+#include "CompuBrite/SFML/SpriteEntity.h"
+#include "CompuBrite/SFML/TaskBatch.h"
 
+#include <algorithm>
 #include <array>
+#include <cmath>
+#include <limits>
+#include <memory>
 #include <ostream>
+#include <thread>
+#include <tuple>
 
 std::ostream&
 operator<<(std::ostream &os, const sf::Vector2f &v)
@@ -38,136 +49,741 @@ operator<<(std::ostream &os, const sf::Vector2f &v)
 
 namespace CompuBrite::SFML {
 
+/// A CircleEntity with at least this many points is treated as a circle,
+/// fewer and it is treated as the polygon it draws, (e.g. a triangle).
+static constexpr std::size_t minCirclePoints = 8;
+
+/// A convex polygon in world space, stored as separate x and y arrays.
+struct Polygon
+{
+    const float *xs;
+    const float *ys;
+    std::size_t  count;
+};
+
+/// Project the points of a polygon onto an axis.  The points are processed in
+/// independent lanes so the loop vectorizes.
+/// @param polygon The points to project.
+/// @param nx, ny The axis.
+/// @param[out] lo, hi The extent of the projection.
+static void
+project(const Polygon &polygon, float nx, float ny, float &lo, float &hi)
+{
+    constexpr std::size_t lanes = 4;
+    std::array<float, lanes> mins;
+    std::array<float, lanes> maxs;
+    mins.fill(std::numeric_limits<float>::max());
+    maxs.fill(std::numeric_limits<float>::lowest());
+
+    std::size_t i = 0;
+    for (; i + lanes <= polygon.count; i += lanes) {
+        for (std::size_t k = 0; k < lanes; ++k) {
+            const auto d = polygon.xs[i + k] * nx + polygon.ys[i + k] * ny;
+            mins[k] = d < mins[k] ? d : mins[k];
+            maxs[k] = d > maxs[k] ? d : maxs[k];
+        }
+    }
+    for (; i < polygon.count; ++i) {
+        const auto d = polygon.xs[i] * nx + polygon.ys[i] * ny;
+        mins[0] = d < mins[0] ? d : mins[0];
+        maxs[0] = d > maxs[0] ? d : maxs[0];
+    }
+    lo = *std::min_element(mins.begin(), mins.end());
+    hi = *std::max_element(maxs.begin(), maxs.end());
+}
+
+/// @return true if one of the edge normals of lhs separates the polygons.
+static bool
+separatedByEdgesOf(const Polygon &lhs, const Polygon &rhs)
+{
+    for (std::size_t i = 0, j = lhs.count - 1; i < lhs.count; j = i++) {
+        const auto nx = lhs.ys[j] - lhs.ys[i];
+        const auto ny = lhs.xs[i] - lhs.xs[j];
+        float lhsMin, lhsMax, rhsMin, rhsMax;
+        project(lhs, nx, ny, lhsMin, lhsMax);
+        project(rhs, nx, ny, rhsMin, rhsMax);
+        if (lhsMax < rhsMin || rhsMax < lhsMin) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// Separating Axis Theorem for two convex polygons.
 static bool
-satRectangleAndPoints(const sf::Vector2f &rectangleSize,
-                      const std::array<sf::Vector2f, 4> &points)
+satPolygons(const Polygon &lhs, const Polygon &rhs)
 {
-    auto allPointsLeftOfRectangle = true;
-    auto allPointsRightOfRectangle = true;
-    auto allPointsAboveRectangle = true;
-    auto allPointsBelowRectangle = true;
+    return !separatedByEdgesOf(lhs, rhs) && !separatedByEdgesOf(rhs, lhs);
+}
 
-    for (const auto &point : points) {
-        if (point.x >= 0.f) {
-            allPointsLeftOfRectangle = false;
+/// Separating Axis Theorem for a circle and a convex polygon.  The axes are
+/// the polygon's edge normals, and the axis from the circle's center to the
+/// polygon's nearest point.
+static bool
+satCirclePolygon(const sf::Vector2f &center, float radius, const Polygon &polygon)
+{
+    auto separated = [&](float nx, float ny) {
+        const auto length = std::sqrt(nx * nx + ny * ny);
+        if (length == 0.0f) {
+            return false;
         }
-        if (point.x <= rectangleSize.x) {
-            allPointsRightOfRectangle = false;
+        nx /= length;
+        ny /= length;
+        float lo, hi;
+        project(polygon, nx, ny, lo, hi);
+        const auto c = center.x * nx + center.y * ny;
+        return c + radius < lo || hi < c - radius;
+    };
+
+    auto nearest = std::numeric_limits<float>::max();
+    sf::Vector2f axis;
+    for (std::size_t i = 0, j = polygon.count - 1; i < polygon.count; j = i++) {
+        if (separated(polygon.ys[j] - polygon.ys[i], polygon.xs[i] - polygon.xs[j])) {
+            return false;
         }
-        if (point.y >= 0.f) {
-            allPointsAboveRectangle = false;
+        const sf::Vector2f d(polygon.xs[i] - center.x, polygon.ys[i] - center.y);
+        const auto distance = d.x * d.x + d.y * d.y;
+        if (distance < nearest) {
+            nearest = distance;
+            axis = d;
         }
-        if (point.y <= rectangleSize.y) {
-            allPointsBelowRectangle = false;
+    }
+    return !separated(axis.x, axis.y);
+}
+
+/// @return true if the two circles overlap.
+static bool
+circles(const sf::Vector2f &lhsCenter, float lhsRadius,
+        const sf::Vector2f &rhsCenter, float rhsRadius)
+{
+    const auto d = lhsCenter - rhsCenter;
+    const auto r = lhsRadius + rhsRadius;
+    return d.x * d.x + d.y * d.y <= r * r;
+}
+
+/// @return The dot product of the given vectors.
+static float
+dot(const sf::Vector2f &lhs, const sf::Vector2f &rhs)
+{
+    return lhs.x * rhs.x + lhs.y * rhs.y;
+}
+
+/// Closed form test of a circle against an oriented box.  The closest point
+/// of the box to the circle's center is found by clamping the center to the
+/// box's half extents along its axes.
+/// @param center, radius The circle.
+/// @param obb The box.
+static bool
+circleBox(const sf::Vector2f &center, float radius, const CollisionSystem::OBB &obb)
+{
+    const auto d = center - obb.center;
+    const auto s = std::clamp(dot(d, obb.axes[0]), -obb.half.x, obb.half.x);
+    const auto t = std::clamp(dot(d, obb.axes[1]), -obb.half.y, obb.half.y);
+    const auto gap = d - obb.axes[0] * s - obb.axes[1] * t;
+    return dot(gap, gap) <= radius * radius;
+}
+
+/// Separating Axis Theorem for two oriented boxes.  Each box only has two
+/// axes to test, and each test is a handful of dot products.
+static bool
+boxes(const CollisionSystem::OBB &lhs, const CollisionSystem::OBB &rhs)
+{
+    const auto d = rhs.center - lhs.center;
+    auto separated = [&d](const CollisionSystem::OBB &a, const CollisionSystem::OBB &b) {
+        for (std::size_t i = 0; i < 2; ++i) {
+            const auto &axis = a.axes[i];
+            const auto ra = i == 0 ? a.half.x : a.half.y;
+            const auto rb = std::abs(dot(b.axes[0], axis)) * b.half.x +
+                            std::abs(dot(b.axes[1], axis)) * b.half.y;
+            if (std::abs(dot(d, axis)) > ra + rb) {
+                return true;
+            }
         }
+        return false;
+    };
+    return !separated(lhs, rhs) && !separated(rhs, lhs);
+}
+
+/// Below this many candidate pairs per thread, the narrow-phase is not worth
+/// splitting across the ThreadPool.
+static constexpr std::size_t pairsPerThread = 256;
+
+/// Sweep two boxes along their motion over one update, using the slab method
+/// on their relative motion.
+/// @param lhs, rhs The boxes at the end of the update.
+/// @param lhsMotion, rhsMotion How far each box moved during the update.
+/// @param[out] toi The fraction of the update at which they first touch.
+/// @return true if the boxes touch at some point during the update.
+static bool
+sweep(const sf::FloatRect &lhs, const sf::Vector2f &lhsMotion,
+      const sf::FloatRect &rhs, const sf::Vector2f &rhsMotion, float &toi)
+{
+    const sf::Vector2f lower(lhs.left - lhsMotion.x, lhs.top - lhsMotion.y);
+    const sf::Vector2f upper(lower.x + lhs.width, lower.y + lhs.height);
+    const sf::Vector2f otherLower(rhs.left - rhsMotion.x, rhs.top - rhsMotion.y);
+    const sf::Vector2f otherUpper(otherLower.x + rhs.width, otherLower.y + rhs.height);
+    const auto velocity = lhsMotion - rhsMotion;
+
+    auto enter = 0.0f;
+    auto exit = 1.0f;
+    auto slab = [&](float lo, float hi, float otherLo, float otherHi, float v) {
+        if (v == 0.0f) {
+            return lo < otherHi && otherLo < hi;
+        }
+        auto t1 = (otherLo - hi) / v;
+        auto t2 = (otherHi - lo) / v;
+        if (t2 < t1) {
+            std::swap(t1, t2);
+        }
+        enter = std::max(enter, t1);
+        exit = std::min(exit, t2);
+        return enter < exit;
+    };
+    if (!slab(lower.x, upper.x, otherLower.x, otherUpper.x, velocity.x) ||
+        !slab(lower.y, upper.y, otherLower.y, otherUpper.y, velocity.y)) {
+        return false;
     }
-    return !(allPointsAboveRectangle || allPointsBelowRectangle ||
-             allPointsLeftOfRectangle || allPointsRightOfRectangle);
+    toi = enter;
+    return true;
 }
 
-CollisionSystem::CollisionSystem(Level level) :
-    level_(level)
+CollisionSystem::CollisionSystem(Level level, float margin) :
+    level_(level),
+    tree_(margin)
 {
 }
 
 void
 CollisionSystem::update(Context &target, sf::Time dt)
 {
-    checkCollisions();
+    checkCollisions(target);
 }
 
-CollisionSystem::Handler
-CollisionSystem::find(const TypeIDs &p) const
+void
+CollisionSystem::addProperties(IEntity &entity)
 {
-    auto found = handlers_.find(p);
-    return (found == handlers_.end()) ? Handler() : found->second;
+    Proxy proxy;
+    proxy.shape = dynamic_cast<const IShapeEntity*>(&entity);
+    proxy.circle = dynamic_cast<const CircleEntity*>(&entity);
+    proxy.sprite = dynamic_cast<const SpriteEntity*>(&entity);
+    proxies_.emplace(&entity, proxy);
 }
 
 void
-CollisionSystem::handleCollision(IEntity &lhs, IEntity &rhs, const sf::FloatRect &rect) const
+CollisionSystem::dropProperties(IEntity &entity)
 {
-    auto t1 = &typeid(lhs);
-    auto t2 = &typeid(rhs);
-    auto p = std::minmax(t1, t2);
-    auto handler = find(p);
-    if (!handler.second) {
-        CheckPoint::hit(CBI_HERE, "no handler");
+    auto found = proxies_.find(&entity);
+    if (found == proxies_.end()) {
         return;
     }
-    if ((t2 < t1) == handler.first) {
-        handler.second(lhs, rhs, rect);
-    } else {
-        handler.second(rhs, lhs, rect);
+    if (found->second.id != DynamicTree::Null) {
+        tree_.destroyProxy(found->second.id);
+    }
+    if (found->second.fixed) {
+        // Indices into statics_ may still be in use, so only forget the
+        // IEntity until the next update rebuilds them.
+        for (auto &collider : statics_) {
+            if (collider.entity == &entity) {
+                collider.entity = nullptr;
+            }
+        }
+        staticsDirty_ = true;
+    } else if (found->second.index < colliders_.size() &&
+               colliders_[found->second.index].entity == &entity) {
+        // A handler may drop entities while contacts still refer to this
+        // Collider, so only forget the IEntity until the next update.
+        colliders_[found->second.index].entity = nullptr;
+    }
+    proxies_.erase(found);
+
+    touching_.erase(std::remove_if(touching_.begin(), touching_.end(), [&entity](const Touch &touch) {
+                        return touch.lhs == &entity || touch.rhs == &entity;
+                    }),
+                    touching_.end());
+}
+
+void
+CollisionSystem::setFilter(IEntity &entity, std::uint32_t category, std::uint32_t mask)
+{
+    auto l = lock();
+    auto found = proxies_.find(&entity);
+    if (!CheckPoint::expect(CBI_HERE, found != proxies_.end(), "Entity not in this CollisionSystem")) {
+        return;
+    }
+    auto &proxy = found->second;
+    proxy.category = category;
+    proxy.mask = mask;
+    if (proxy.id != DynamicTree::Null) {
+        tree_.setCategories(proxy.id, category);
+    }
+    if (proxy.fixed) {
+        staticsDirty_ = true;
+    }
+    proxy.changed = true;
+}
+
+void
+CollisionSystem::setContinuous(IEntity &entity, bool continuous)
+{
+    auto l = lock();
+    auto found = proxies_.find(&entity);
+    if (!CheckPoint::expect(CBI_HERE, found != proxies_.end(), "Entity not in this CollisionSystem")) {
+        return;
     }
+    found->second.continuous = continuous;
+}
+
+void
+CollisionSystem::setStatic(IEntity &entity, bool fixed)
+{
+    auto l = lock();
+    auto found = proxies_.find(&entity);
+    if (!CheckPoint::expect(CBI_HERE, found != proxies_.end(), "Entity not in this CollisionSystem")) {
+        return;
+    }
+    auto &proxy = found->second;
+    if (fixed && proxy.id != DynamicTree::Null) {
+        tree_.destroyProxy(proxy.id);
+        proxy.id = DynamicTree::Null;
+    }
+    staticsDirty_ = staticsDirty_ || fixed || proxy.fixed;
+    proxy.fixed = fixed;
+}
+
+std::vector<IEntity*>
+CollisionSystem::queryAABB(const sf::FloatRect &rect, std::uint32_t mask)
+{
+    auto l = lock();
+    std::vector<IEntity*> found;
+    auto test = [&rect, &found](const Collider &collider) {
+        if (collider.entity && collider.bounds.intersects(rect)) {
+            found.push_back(collider.entity);
+        }
+        return true;
+    };
+    const DynamicTree::AABB aabb(rect);
+    tree_.query(aabb, mask, [this, &test](int proxy) { return test(colliders_[tree_.getIndex(proxy)]); });
+    staticTree_.query(aabb, mask, [this, &test](std::size_t index) { return test(statics_[index]); });
+    return found;
+}
+
+std::vector<IEntity*>
+CollisionSystem::queryPoint(const sf::Vector2f &point, std::uint32_t mask)
+{
+    auto l = lock();
+    std::vector<IEntity*> found;
+    auto test = [&point, &found](const Collider &collider) {
+        if (collider.entity && collider.local.contains(collider.inverse.transformPoint(point))) {
+            found.push_back(collider.entity);
+        }
+        return true;
+    };
+    const DynamicTree::AABB aabb(point, point);
+    tree_.query(aabb, mask, [this, &test](int proxy) { return test(colliders_[tree_.getIndex(proxy)]); });
+    staticTree_.query(aabb, mask, [this, &test](std::size_t index) { return test(statics_[index]); });
+    return found;
 }
 
 bool
-CollisionSystem::didCollide(const IEntity &lhs, const IEntity &rhs, sf::FloatRect &rect) const
+CollisionSystem::raycast(const sf::Vector2f &from, const sf::Vector2f &to, RayHit &hit,
+                         std::uint32_t mask)
 {
-    if (!CheckPoint::expect(CBI_HERE, &lhs != &rhs, "lhs == rhs.  Shouldn't have happened!")) {
-        // objects don't collide with themselves.
+    auto l = lock();
+    const Collider *closest = nullptr;
+    auto closestFraction = 1.0f;
+    auto test = [&](const Collider &collider, float maxFraction) {
+        // Nothing beyond the closest hit in either tree matters.
+        maxFraction = std::min(maxFraction, closestFraction);
+        if (!collider.entity) {
+            return maxFraction;
+        }
+        // The transform is affine, so the fraction along the ray is the same
+        // in local space.
+        const auto localFrom = collider.inverse.transformPoint(from);
+        const auto localTo = collider.inverse.transformPoint(to);
+        float fraction;
+        if (!DynamicTree::AABB(collider.local).raycast(localFrom, localTo - localFrom,
+                                                       maxFraction, fraction)) {
+            return maxFraction;
+        }
+        closest = &collider;
+        closestFraction = fraction;
+        return fraction;
+    };
+    tree_.raycast(from, to, mask, [this, &test](int proxy, float maxFraction) {
+        return test(colliders_[tree_.getIndex(proxy)], maxFraction);
+    });
+    staticTree_.raycast(from, to, mask, [this, &test](std::size_t index, float maxFraction) {
+        return test(statics_[index], maxFraction);
+    });
+    if (!closest) {
         return false;
     }
 
-    // Now check level 0, (AABB)
-    const auto level0 = lhs.getGlobalBounds().intersects(rhs.getGlobalBounds(), rect);
-    if (!level0 || level_ == AABB) {
-        // If they don't intersect, or we're only checking AABB return now.
-        return level0;
+    const auto direction = to - from;
+    hit.entity = closest->entity;
+    hit.point = from + direction * closestFraction;
+    hit.distance = closestFraction * std::sqrt(direction.x * direction.x + direction.y * direction.y);
+    return true;
+}
+
+void
+CollisionSystem::addOutline(Collider &collider, const Proxy &proxy,
+                            std::vector<float> &xs, std::vector<float> &ys)
+{
+    auto l = collider.entity->lock();
+    if (proxy.shape && proxy.shape->getPointCount() >= 3) {
+        const auto count = proxy.shape->getPointCount();
+        for (std::size_t i = 0; i < count; ++i) {
+            const auto point = collider.transform.transformPoint(proxy.shape->getPoint(i));
+            xs.push_back(point.x);
+            ys.push_back(point.y);
+        }
+    } else {
+        const auto &local = collider.local;
+        const auto right = local.left + local.width;
+        const auto bottom = local.top + local.height;
+        for (const auto &corner : {sf::Vector2f(local.left, local.top), sf::Vector2f(right, local.top),
+                                   sf::Vector2f(right, bottom), sf::Vector2f(local.left, bottom)}) {
+            const auto point = collider.transform.transformPoint(corner);
+            xs.push_back(point.x);
+            ys.push_back(point.y);
+        }
+    }
+    collider.count = xs.size() - collider.first;
+}
+
+void
+CollisionSystem::makeOBB(Collider &collider)
+{
+    // The columns of the matrix are the local axes in world space, scaled.
+    const auto m = collider.transform.getMatrix();
+    const sf::Vector2f x(m[0], m[1]);
+    const sf::Vector2f y(m[4], m[5]);
+    const auto sx = std::sqrt(dot(x, x));
+    const auto sy = std::sqrt(dot(y, y));
+    const auto &local = collider.local;
+
+    auto &obb = collider.obb;
+    obb.center = collider.transform.transformPoint(local.left + local.width / 2.0f,
+                                                   local.top + local.height / 2.0f);
+    obb.axes[0] = (sx > 0.0f) ? x / sx : sf::Vector2f(1.0f, 0.0f);
+    obb.axes[1] = (sy > 0.0f) ? y / sy : sf::Vector2f(0.0f, 1.0f);
+    obb.half = sf::Vector2f(std::abs(local.width) * sx, std::abs(local.height) * sy) / 2.0f;
+}
+
+void
+CollisionSystem::findCircle(Collider &collider, const Proxy &proxy)
+{
+    auto l = collider.entity->lock();
+    if (proxy.circle->getPointCount() < minCirclePoints) {
+        return;
+    }
+    // Only a true circle under uniform scale.
+    const auto m = collider.transform.getMatrix();
+    const auto sx = std::hypot(m[0], m[1]);
+    const auto sy = std::hypot(m[4], m[5]);
+    if (std::abs(sx - sy) <= 1e-4f * std::max(sx, sy)) {
+        const auto radius = proxy.circle->getRadius();
+        collider.center = collider.transform.transformPoint(radius, radius);
+        collider.radius = radius * sx;
+    }
+}
+
+CollisionSystem::Collider
+CollisionSystem::makeCollider(IEntity *entity, Proxy &proxy,
+                              std::vector<float> &xs, std::vector<float> &ys)
+{
+    if (proxy.types != types_) {
+        // Handlers were added since this was last looked up.
+        auto found = typeIDs_.find(&typeid(*entity));
+        proxy.type = (found == typeIDs_.end()) ? 0 : found->second;
+        proxy.types = types_;
+    }
+
+    Collider collider;
+    collider.entity = entity;
+    collider.type = proxy.type;
+    collider.category = proxy.category;
+    collider.mask = proxy.mask;
+    collider.transform = entity->getGlobalTransform();
+    collider.inverse = collider.transform.getInverse();
+    if (true) {
+        auto l = entity->lock();
+        collider.local = entity->getLocalBounds();
+    }
+    collider.bounds = collider.transform.transformRect(collider.local);
+    collider.swept = collider.bounds;
+    collider.motion = sf::Vector2f();
+    collider.continuous = false;
+    collider.fixed = proxy.fixed;
+    collider.moved = true;
+
+    collider.radius = 0.0f;
+    if (level_ >= BB && proxy.circle) {
+        findCircle(collider, proxy);
+    }
+
+    collider.box = !proxy.shape && collider.radius == 0.0f;
+    if (level_ >= BB && collider.radius == 0.0f) {
+        // Circles are tested with their radius, so they don't need a box.
+        makeOBB(collider);
+    }
+
+    collider.first = xs.size();
+    collider.count = 0;
+    if (level_ >= SAT && collider.radius == 0.0f) {
+        addOutline(collider, proxy, xs, ys);
+    }
+    collider.pixels = nullptr;
+    if (level_ == PIXEL && proxy.sprite) {
+        auto l = entity->lock();
+        collider.pixels = proxy.sprite->getAlphaMask();
+    }
+    return collider;
+}
+
+void
+CollisionSystem::buildStatics()
+{
+    statics_.clear();
+    staticXs_.clear();
+    staticYs_.clear();
+    std::vector<StaticTree::Item> items;
+    for (auto entity : entities_) {
+        auto &proxy = proxies_[entity];
+        if (!proxy.fixed) {
+            continue;
+        }
+        const auto collider = makeCollider(entity, proxy, staticXs_, staticYs_);
+        proxy.index = statics_.size();
+        items.push_back({DynamicTree::AABB(collider.bounds), collider.category, statics_.size()});
+        statics_.push_back(collider);
     }
+    staticTree_.build(std::move(items));
+    staticsDirty_ = false;
+    staticsMoved_ = true;
+    staticTypes_ = types_;
+}
 
-    // The AABBs intersect, now check if the BBs intersect;
-    const auto leftTransform = lhs.getGlobalTransform();
-    const auto rightTransform = rhs.getGlobalTransform();
-    const auto leftInverseTransform = leftTransform.getInverse();
-    const auto rightInverseTransform = rightTransform.getInverse();
-    const auto leftBounds = lhs.getLocalBounds();
-    const auto rightBounds = rhs.getLocalBounds();
+void
+CollisionSystem::updateColliders()
+{
+    staticsMoved_ = false;
+    if (staticsDirty_ || staticTypes_ != types_) {
+        buildStatics();
+    }
 
-    const sf::Vector2f leftSize {leftBounds.width, leftBounds.height };
-    const sf::Vector2f rightSize {rightBounds.width, rightBounds.height };
+    colliders_.clear();
+    xs_.clear();
+    ys_.clear();
+    colliders_.reserve(entities_.size() - statics_.size());
+    const auto &journal = IEntity::journal();
+    const auto frame = journal.frame();
+    for (auto entity : entities_) {
+        auto &proxy = proxies_[entity];
+        if (proxy.fixed) {
+            continue;
+        }
+        // Read first, so a change made meanwhile is seen next update.
+        const auto version = entity->getShapeVersion();
+        auto collider = makeCollider(entity, proxy, xs_, ys_);
 
-    auto point = sf::Vector2f(0.f, 0.f);
-    point = leftTransform.transformPoint( point );
-    const auto leftTopLeft = rightInverseTransform.transformPoint(point);
+        // Anything which could change the outcome of a test counts as a move.
+        // A move recorded after frame was read counts again next update, which
+        // only costs a test.
+        collider.moved = proxy.id == DynamicTree::Null || proxy.changed ||
+                         journal.changedSince(*entity, proxy.frame) ||
+                         version != proxy.version ||
+                         collider.local != proxy.local || collider.pixels != proxy.pixels;
+        proxy.frame = frame;
+        proxy.version = version;
+        proxy.local = collider.local;
+        proxy.pixels = collider.pixels;
+        proxy.changed = false;
 
-    point = sf::Vector2f(leftSize.x, 0.f);
-    point = leftTransform.transformPoint( point );
-    const auto leftTopRight = rightInverseTransform.transformPoint(point);
+        const DynamicTree::AABB bounds(collider.bounds);
+        collider.continuous = proxy.continuous && proxy.id != DynamicTree::Null;
+        if (proxy.id == DynamicTree::Null) {
+            proxy.id = tree_.createProxy(bounds, entity, proxy.category);
+        } else {
+            const auto displacement = ((bounds.lower + bounds.upper) -
+                                       (proxy.bounds.lower + proxy.bounds.upper)) / 2.0f;
+            if (collider.continuous) {
+                // The leaf covers the whole step, so the pair is found even
+                // if the IEntity passed right through the other.
+                collider.motion = displacement;
+                collider.swept = DynamicTree::AABB::combine(bounds, proxy.bounds).rect();
+            }
+            tree_.moveProxy(proxy.id, DynamicTree::AABB(collider.swept), displacement);
+        }
+        proxy.bounds = bounds;
+        proxy.index = colliders_.size();
+        tree_.setIndex(proxy.id, colliders_.size());
+        colliders_.push_back(collider);
+    }
+}
 
-    point = leftTransform.transformPoint(leftSize);
-    const auto leftBottomRight = rightInverseTransform.transformPoint(point);
+void
+CollisionSystem::findPairs()
+{
+    pairs_.clear();
+    for (std::size_t index = 0; index < colliders_.size(); ++index) {
+        const auto &collider = colliders_[index];
+        if (!collider.category || !collider.mask) {
+            // Filtered out of all collisions.
+            continue;
+        }
+        const DynamicTree::AABB bounds(collider.swept);
+        if (collider.moved) {
+            // The tree only reports leaves in one of our mask's categories, we
+            // still need to be in one of theirs.  Pairs of Colliders which
+            // haven't moved are reused by reuseContacts().
+            tree_.query(bounds, collider.mask, [this, index, &collider](int other) {
+                // A pair of moved Colliders is reported from both sides, only
+                // keep one.  Pairs are always ordered (lower, higher), as in
+                // reuseContacts() and touching_.
+                const auto otherIndex = tree_.getIndex(other);
+                const auto &found = colliders_[otherIndex];
+                if ((!found.moved || otherIndex > index) && (found.mask & collider.category)) {
+                    pairs_.emplace_back(std::minmax(index, otherIndex));
+                }
+                return true;
+            });
+        }
+        if (collider.moved || staticsMoved_) {
+            // Static IEntity objects are only ever found from the dynamic side.
+            staticTree_.query(bounds, collider.mask, [this, index, &collider](std::size_t other) {
+                if (statics_[other].mask & collider.category) {
+                    pairs_.emplace_back(index, colliders_.size() + other);
+                }
+                return true;
+            });
+        }
+    }
+}
 
-    point = sf::Vector2f( 0.f, leftSize.y );
-    point = leftTransform.transformPoint(point);
-    const auto leftBottomLeft = rightInverseTransform.transformPoint(point);
+std::size_t
+CollisionSystem::typeID(const std::type_info &type)
+{
+    auto found = typeIDs_.find(&type);
+    if (found != typeIDs_.end()) {
+        return found->second;
+    }
+    const auto id = types_;
+    typeIDs_[&type] = id;
 
+    // Grow the table by a row and a column.
+    Handlers handlers((types_ + 1) * (types_ + 1));
+    for (std::size_t row = 0; row < types_; ++row) {
+        for (std::size_t column = 0; column < types_; ++column) {
+            handlers[row * (types_ + 1) + column] = std::move(handlers_[row * types_ + column]);
+        }
+    }
+    handlers_ = std::move(handlers);
+    ++types_;
+    return id;
+}
 
-    point = sf::Vector2f(0.f, 0.f );
-    point = rightTransform.transformPoint(point);
-    const auto rightTopLeft = leftInverseTransform.transformPoint(point);
+void
+CollisionSystem::registerHandler(Phase phase, const std::type_info &t1, const std::type_info &t2,
+                                 Callback callback)
+{
+    if (dispatching_) {
+        // A handler is adding a handler, don't disturb the table under it.
+        pending_.push_back({phase, &t1, &t2, std::move(callback)});
+        return;
+    }
+    insertHandler(phase, t1, t2, std::move(callback));
+}
 
-    point = sf::Vector2f(rightSize.x, 0.f );
-    point = rightTransform.transformPoint(point);
-    const auto rightTopRight = leftInverseTransform.transformPoint(point);
+void
+CollisionSystem::insertHandler(Phase phase, const std::type_info &t1, const std::type_info &t2,
+                               Callback callback)
+{
+    auto l = lock();
+    const auto id1 = typeID(t1);
+    const auto id2 = typeID(t2);
+    handlers_[id2 * types_ + id1][phase] = Handler{callback, true};
+    handlers_[id1 * types_ + id2][phase] = Handler{std::move(callback), false};
+}
 
-    point = rightTransform.transformPoint(rightSize);
-    const auto rightBottomRight = leftInverseTransform.transformPoint(point);
+void
+CollisionSystem::call(const Handler &handler, IEntity &lhs, IEntity &rhs, const sf::FloatRect &rect)
+{
+    if (!handler.callback) {
+        return;
+    }
+    if (handler.swap) {
+        handler.callback(rhs, lhs, rect);
+    } else {
+        handler.callback(lhs, rhs, rect);
+    }
+}
 
-    point = sf::Vector2f( 0.f, rightSize.y );
-    point = rightTransform.transformPoint(point);
-    const auto rightBottomLeft = leftInverseTransform.transformPoint(point);
+void
+CollisionSystem::handleCollision(const Contact &contact) const
+{
+    const auto &lhs = colliderAt(contact.lhs);
+    const auto &rhs = colliderAt(contact.rhs);
+    if (!lhs.entity || !rhs.entity) {
+        // Removed by an earlier handler.
+        return;
+    }
+    const auto &handlers = handlers_[lhs.type * types_ + rhs.type];
+    if (std::none_of(handlers.begin(), handlers.end(), [](const Handler &handler) {
+            return static_cast<bool>(handler.callback);
+        })) {
+        CheckPoint::hit(CBI_HERE, "no handler");
+        return;
+    }
+    call(handlers[Touching], *lhs.entity, *rhs.entity, contact.rect);
+    if (!lhs.entity || !rhs.entity) {
+        // Removed by the Touching handler.
+        return;
+    }
+    call(handlers[contact.begin ? Begin : Stay], *lhs.entity, *rhs.entity, contact.rect);
+}
 
-    const bool level1 =
-        leftBounds.contains(rightTopLeft) ||
-        leftBounds.contains(rightTopRight) ||
-        leftBounds.contains(rightBottomLeft) ||
-        leftBounds.contains(rightBottomRight) ||
-        rightBounds.contains(leftTopLeft) ||
-        rightBounds.contains(leftTopRight) ||
-        rightBounds.contains(leftBottomLeft) ||
-        rightBounds.contains(leftBottomRight);
+void
+CollisionSystem::handleEnd(const Touch &touch) const
+{
+    if (!proxies_.count(touch.lhs) || !proxies_.count(touch.rhs)) {
+        // Removed by an earlier handler.
+        return;
+    }
+    const auto &handler = handlers_[touch.lhsType * types_ + touch.rhsType][End];
+    call(handler, *touch.lhs, *touch.rhs, touch.rect);
+}
 
+bool
+CollisionSystem::didCollide(const Collider &lhs, const Collider &rhs, sf::FloatRect &rect) const
+{
+    if (!CheckPoint::expect(CBI_HERE, lhs.entity != rhs.entity, "lhs == rhs.  Shouldn't have happened!")) {
+        // objects don't collide with themselves.
+        return false;
+    }
+
+    // Now check level 0, (AABB)
+    const auto level0 = lhs.bounds.intersects(rhs.bounds, rect);
+    if (!level0 || level_ == AABB) {
+        // If they don't intersect, or we're only checking AABB return now.
+        return level0;
+    }
+
+    // The AABBs intersect, now check if the BBs intersect.  Circles have a
+    // closed form, and two circles need nothing further.
+    if (lhs.radius > 0.0f && rhs.radius > 0.0f) {
+        return circles(lhs.center, lhs.radius, rhs.center, rhs.radius);
+    }
+    bool level1;
+    if (lhs.radius > 0.0f) {
+        level1 = circleBox(lhs.center, lhs.radius, rhs.obb);
+    } else if (rhs.radius > 0.0f) {
+        level1 = circleBox(rhs.center, rhs.radius, lhs.obb);
+    } else {
+        level1 = boxes(lhs.obb, rhs.obb);
+    }
 
     if (!level1 || level_ == BB) {
         // The transformed boundary rectangles don't intersect or we're only
@@ -175,45 +791,253 @@ CollisionSystem::didCollide(const IEntity &lhs, const IEntity &rhs, sf::FloatRec
         return level1;
     }
 
-    // Now apply the Separating Axis Theorem, (SAT).
-    std::array<sf::Vector2f, 4> leftPoints
-    {
-        leftBottomLeft,
-        leftBottomRight,
-        leftTopRight,
-        leftTopLeft
+    // Now apply the Separating Axis Theorem, (SAT).  A box is its own
+    // outline, so unless a shape is involved the BB level was already exact.
+    auto polygon = [this](const Collider &collider) {
+        const auto &xs = collider.fixed ? staticXs_ : xs_;
+        const auto &ys = collider.fixed ? staticYs_ : ys_;
+        return Polygon{xs.data() + collider.first, ys.data() + collider.first, collider.count};
+    };
+    auto exact = [](const Collider &collider) { return collider.box || collider.radius > 0.0f; };
+    bool level2 = level1;
+    if (exact(lhs) && exact(rhs)) {
+        // Exact already.
+    } else if ((!exact(lhs) && lhs.count < 3) || (!exact(rhs) && rhs.count < 3)) {
+        // Fewer than three points enclose nothing, (an empty ConvexEntity).
+        level2 = false;
+    } else if (lhs.radius > 0.0f) {
+        level2 = satCirclePolygon(lhs.center, lhs.radius, polygon(rhs));
+    } else if (rhs.radius > 0.0f) {
+        level2 = satCirclePolygon(rhs.center, rhs.radius, polygon(lhs));
+    } else {
+        level2 = satPolygons(polygon(lhs), polygon(rhs));
+    }
+
+    if (!level2 || level_ == SAT) {
+        return level2;
+    }
+
+    // Finally compare the solid pixels, in the local space of the other.
+    if (lhs.pixels) {
+        return lhs.pixels->overlaps(rhs.inverse * lhs.transform, rhs.pixels, rhs.local);
+    }
+    if (rhs.pixels) {
+        return rhs.pixels->overlaps(lhs.inverse * rhs.transform, nullptr, lhs.local);
+    }
+    return true;
+}
+
+bool
+CollisionSystem::didSweep(const Collider &lhs, const Collider &rhs, sf::FloatRect &rect, float &toi) const
+{
+    if (!sweep(lhs.bounds, lhs.motion, rhs.bounds, rhs.motion, toi)) {
+        return false;
+    }
+    if (lhs.bounds.intersects(rhs.bounds)) {
+        // Still overlapping at the end of the update, so the requested level
+        // has the final say.
+        return didCollide(lhs, rhs, rect);
+    }
+
+    // They passed through each other, report where the boxes met.
+    const auto back = 1.0f - toi;
+    auto at = [back](const Collider &collider) {
+        return sf::FloatRect(collider.bounds.left - collider.motion.x * back,
+                             collider.bounds.top - collider.motion.y * back,
+                             collider.bounds.width, collider.bounds.height);
     };
+    const auto first = at(lhs);
+    const auto second = at(rhs);
+    const auto left = std::max(first.left, second.left);
+    const auto top = std::max(first.top, second.top);
+    const auto right = std::min(first.left + first.width, second.left + second.width);
+    const auto bottom = std::min(first.top + first.height, second.top + second.height);
+    rect = sf::FloatRect(left, top, std::max(0.0f, right - left), std::max(0.0f, bottom - top));
+    return true;
+}
+
+void
+CollisionSystem::testPairs(std::size_t chunk, std::size_t chunks)
+{
+    auto &buffer = buffers_[chunk];
+    const auto begin = pairs_.size() * chunk / chunks;
+    const auto end = pairs_.size() * (chunk + 1) / chunks;
+    for (auto pair = begin; pair != end; ++pair) {
+        const auto [lhs, rhs] = pairs_[pair];
+        const auto &left = colliderAt(lhs);
+        const auto &right = colliderAt(rhs);
+        sf::FloatRect rect;
+        auto toi = 1.0f;
+        if ((left.continuous || right.continuous) ? didSweep(left, right, rect, toi)
+                                                  : didCollide(left, right, rect)) {
+            buffer.push_back({lhs, rhs, rect, false, toi});
+        }
+    }
+}
+
+void
+CollisionSystem::narrowPhase(Context &target)
+{
+    const auto threads = std::max(1u, std::thread::hardware_concurrency());
+    const auto chunks = std::clamp<std::size_t>(pairs_.size() / pairsPerThread, 1, threads);
+    buffers_.resize(std::max(buffers_.size(), chunks));
+    for (auto &buffer : buffers_) {
+        buffer.clear();
+    }
 
-    std::array<sf::Vector2f, 4> rightPoints
-    {
-        rightBottomLeft,
-        rightBottomRight,
-        rightTopRight,
-        rightTopLeft
+    if (chunks == 1) {
+        testPairs(0, 1);
+    } else {
+        auto batch = std::make_shared<TaskBatch>(chunks);
+        for (std::size_t helper = 1; helper < chunks; ++helper) {
+            target.addTask([this, batch] {
+                batch->run([this, batch](std::size_t chunk) { testPairs(chunk, batch->chunks); });
+            });
+        }
+        batch->run([this, chunks](std::size_t chunk) { testPairs(chunk, chunks); });
+        batch->wait();
+    }
+
+    contacts_.clear();
+    for (auto &buffer : buffers_) {
+        contacts_.insert(contacts_.end(), buffer.begin(), buffer.end());
+    }
+}
+
+void
+CollisionSystem::reuseContacts()
+{
+    for (const auto &touch : touching_) {
+        const auto &lhsProxy = proxies_.find(touch.lhs)->second;
+        const auto &rhsProxy = proxies_.find(touch.rhs)->second;
+        auto lhs = lhsProxy.fixed ? colliders_.size() + lhsProxy.index : lhsProxy.index;
+        auto rhs = rhsProxy.fixed ? colliders_.size() + rhsProxy.index : rhsProxy.index;
+        const auto &left = colliderAt(lhs);
+        const auto &right = colliderAt(rhs);
+        if (moved(left) || moved(right) || !left.bounds.intersects(right.bounds)) {
+            // Either tested again this update, or only met during a sweep.
+            continue;
+        }
+        if (rhs < lhs) {
+            std::swap(lhs, rhs);
+        }
+        const auto toi = (left.continuous || right.continuous) ? 0.0f : 1.0f;
+        contacts_.push_back({lhs, rhs, touch.rect, false, toi});
+    }
+
+    // Order by registration, (as testing every pair in turn would), so
+    // handlers always run in the same order.
+    std::sort(contacts_.begin(), contacts_.end(), [](const Contact &lhs, const Contact &rhs) {
+        return std::tie(lhs.lhs, lhs.rhs) < std::tie(rhs.lhs, rhs.rhs);
+    });
+}
+
+void
+CollisionSystem::updateTouching()
+{
+    auto before = [](const Touch &lhs, const Touch &rhs) {
+        return std::tie(lhs.lhs, lhs.rhs) < std::tie(rhs.lhs, rhs.rhs);
     };
 
-    return satRectangleAndPoints(rightSize, leftPoints) &&
-           satRectangleAndPoints(leftSize, rightPoints);
+    Touches touching;
+    touching.reserve(contacts_.size());
+    for (auto &contact : contacts_) {
+        const auto &lhs = colliderAt(contact.lhs);
+        const auto &rhs = colliderAt(contact.rhs);
+        Touch touch{lhs.entity, rhs.entity, lhs.type, rhs.type, contact.rect};
+        if (touch.rhs < touch.lhs) {
+            std::swap(touch.lhs, touch.rhs);
+            std::swap(touch.lhsType, touch.rhsType);
+        }
+
+        auto found = std::lower_bound(touching_.begin(), touching_.end(), touch, before);
+        contact.begin = (found == touching_.end() || before(touch, *found));
+        if (!contact.begin) {
+            found->seen = true;
+        }
+        touching.push_back(touch);
+    }
+
+    ended_.clear();
+    for (const auto &touch : touching_) {
+        if (!touch.seen) {
+            ended_.push_back(touch);
+        }
+    }
+    std::sort(touching.begin(), touching.end(), before);
+    touching_ = std::move(touching);
 }
 
 void
-CollisionSystem::checkCollisions() const
+CollisionSystem::setDebugDraw(DebugDraw *debug)
 {
-    if (entities_.size() < 2) {
-        // Need at least 2 entities to have a collision.
+    auto l = lock();
+    debug_ = debug;
+}
+
+void
+CollisionSystem::debugDraw() const
+{
+    if (!debug_) {
         return;
     }
-    for (auto first = entities_.begin(); first != entities_.end(); ++first) {
-        auto next = first;
-        for (++next; next != entities_.end(); ++next) {
-            sf::FloatRect rect;
-            if (didCollide(**first, **next, rect)) {
-                //CheckPoint::hit(CBI_HERE, "Collision");
-                handleCollision(**first, **next, rect);
-            }
+    const sf::Color node(96, 96, 96);
+    const sf::Color leaf(0, 128, 255);
+    tree_.visit([this, &node, &leaf](const DynamicTree::AABB &aabb, int height) {
+        debug_->rect(aabb.rect(), height ? node : leaf);
+    });
+    for (auto &collider : statics_) {
+        if (collider.entity) {
+            debug_->rect(collider.bounds, sf::Color::White);
+        }
+    }
+    for (auto &collider : colliders_) {
+        debug_->rect(collider.bounds, collider.moved ? sf::Color::Green : sf::Color::Yellow);
+    }
+    for (auto &contact : contacts_) {
+        debug_->rect(contact.rect, sf::Color::Red);
+    }
+    debug_->present();
+}
+
+void
+CollisionSystem::checkCollisions(Context &target)
+{
+    if (true) {
+        auto l = lock();
+        updateColliders();
+        if ((colliders_.empty() || colliders_.size() + statics_.size() < 2) && touching_.empty()) {
+            // Need at least 2 entities, one dynamic, to have a collision.
+            contacts_.clear();
+            debugDraw();
+            return;
         }
+        findPairs();
+        // Workers only read the colliders, so hold the lock until dispatch to
+        // keep addEntity/dropEntity from reallocating them underneath.
+        narrowPhase(target);
+        reuseContacts();
+        updateTouching();
+        debugDraw();
     }
 
+    dispatching_ = true;
+    for (const auto &contact : contacts_) {
+        //CheckPoint::hit(CBI_HERE, "Collision");
+        toi_ = contact.toi;
+        handleCollision(contact);
+    }
+    toi_ = 1.0f;
+    for (const auto &touch : ended_) {
+        handleEnd(touch);
+    }
+    dispatching_ = false;
+
+    for (auto &registration : pending_) {
+        insertHandler(registration.phase, *registration.t1, *registration.t2,
+                      std::move(registration.callback));
+    }
+    pending_.clear();
 }
 
 } // namespace CompuBrite::SFML
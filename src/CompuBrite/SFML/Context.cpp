@@ -26,6 +26,7 @@
 
 #include <SFML/System/Sleep.hpp>
 #include "CompuBrite/SFML/Context.h"
+#include "CompuBrite/SFML/IEntity.h"
 
 namespace CompuBrite:: SFML {
 
@@ -42,6 +43,7 @@ Context::update()
         while (_elapsed > _timeSlice) {
             _elapsed -= _timeSlice;
             _stack.update(_timeSlice, *this);
+            IEntity::journal().advance();
         }
     }
 }
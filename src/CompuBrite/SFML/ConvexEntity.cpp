@@ -27,22 +27,21 @@
 
 namespace CompuBrite::SFML {
 
-ConvexEntity::ConvexEntity(std::size_t pointCount) :
-    IShapeEntity(shape_),
-    shape_(pointCount)
+ConvexEntity::ConvexEntity(std::size_t pointCount)
 {
+    editPoints().resize(pointCount);
 }
 
 void
 ConvexEntity::setPointCount(std::size_t count)
 {
-    shape_.setPointCount(count);
+    editPoints().resize(count);
 }
 
 void
 ConvexEntity::setPoint(std::size_t index, const sf::Vector2f &point)
 {
-    shape_.setPoint(index, point);
+    editPoints()[index] = point;
 }
 
 } // namespace CompuBrite::SFML
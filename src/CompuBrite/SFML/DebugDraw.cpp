@@ -0,0 +1,117 @@
+/**
+ * The MIT License (MIT)
+ *
+ * @copyright
+ * Copyright (c) 2020 Rich Newman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @file
+ * @brief Implementation for DebugDraw
+*/
+
+#include "CompuBrite/SFML/DebugDraw.h"
+
+#include <SFML/Graphics/RenderTarget.hpp>
+
+#include <cmath>
+
+namespace CompuBrite::SFML {
+
+void
+DebugDraw::line(const sf::Vector2f &from, const sf::Vector2f &to, const sf::Color &color)
+{
+    auto l = lock();
+    building_.emplace_back(from, color);
+    building_.emplace_back(to, color);
+}
+
+void
+DebugDraw::rect(const sf::FloatRect &rect, const sf::Color &color)
+{
+    sf::Vector2f corners[4] = {
+        {rect.left, rect.top},
+        {rect.left + rect.width, rect.top},
+        {rect.left + rect.width, rect.top + rect.height},
+        {rect.left, rect.top + rect.height},
+    };
+    auto l = lock();
+    for (int i = 0; i < 4; ++i) {
+        building_.emplace_back(corners[i], color);
+        building_.emplace_back(corners[(i + 1) % 4], color);
+    }
+}
+
+void
+DebugDraw::circle(const sf::Vector2f &center, float radius, const sf::Color &color,
+                  std::size_t segments)
+{
+    static const float pi = 3.141592654f;
+
+    auto l = lock();
+    sf::Vector2f last(center.x + radius, center.y);
+    for (std::size_t i = 1; i <= segments; ++i) {
+        auto angle = i * 2 * pi / segments;
+        sf::Vector2f next(center.x + std::cos(angle) * radius, center.y + std::sin(angle) * radius);
+        building_.emplace_back(last, color);
+        building_.emplace_back(next, color);
+        last = next;
+    }
+}
+
+void
+DebugDraw::point(const sf::Vector2f &position, const sf::Color &color, float size)
+{
+    auto l = lock();
+    building_.emplace_back(sf::Vector2f(position.x - size, position.y), color);
+    building_.emplace_back(sf::Vector2f(position.x + size, position.y), color);
+    building_.emplace_back(sf::Vector2f(position.x, position.y - size), color);
+    building_.emplace_back(sf::Vector2f(position.x, position.y + size), color);
+}
+
+void
+DebugDraw::present()
+{
+    auto l = lock();
+    shown_.swap(building_);
+    building_.clear();
+}
+
+void
+DebugDraw::clear()
+{
+    auto l = lock();
+    building_.clear();
+}
+
+void
+DebugDraw::draw(sf::RenderTarget &target, sf::RenderStates states) const
+{
+    auto l = lock();
+    if (!shown_.empty()) {
+        target.draw(shown_.data(), shown_.size(), sf::Lines, states);
+    }
+}
+
+std::size_t
+DebugDraw::getLineCount() const
+{
+    auto l = lock();
+    return shown_.size() / 2;
+}
+
+} // namespace CompuBrite::SFML
@@ -26,43 +26,229 @@
 
 #include "CompuBrite/SFML/DrawingSystem.h"
 #include "CompuBrite/SFML/Context.h"
+#include "CompuBrite/SFML/IBatchable.h"
 #include <SFML/Graphics/RenderTarget.hpp>
-#include <SFML/Graphics/RectangleShape.hpp>
 
-#include <map>
+#include <algorithm>
+#include <array>
+#include <limits>
 
 namespace CompuBrite::SFML {
 
+namespace {
+
+/// Map a signed value onto 16 unsigned bits, keeping its order.
+std::uint64_t
+bias16(int value)
+{
+    auto clamped = std::clamp(value,
+                              static_cast<int>(std::numeric_limits<std::int16_t>::min()),
+                              static_cast<int>(std::numeric_limits<std::int16_t>::max()));
+    return static_cast<std::uint64_t>(clamped + 0x8000);
+}
+
+/// Stable LSD radix sort of items by key, one byte per pass.  Passes where
+/// every key has the same byte are skipped, which is most of them in
+/// practice.
+template <typename Item>
+void
+radixSort(std::vector<Item> &items, std::vector<Item> &scratch)
+{
+    scratch.resize(items.size());
+    for (unsigned shift = 0; shift < 64; shift += 8) {
+        std::array<std::size_t, 256> counts{};
+        for (auto &item : items) {
+            ++counts[(item.key >> shift) & 0xff];
+        }
+        if (counts[(items.front().key >> shift) & 0xff] == items.size()) {
+            continue;
+        }
+        std::size_t offset = 0;
+        for (auto &count : counts) {
+            auto n = count;
+            count = offset;
+            offset += n;
+        }
+        for (auto &item : items) {
+            scratch[counts[(item.key >> shift) & 0xff]++] = item;
+        }
+        items.swap(scratch);
+    }
+}
+
+} // namespace
+
 DrawingSystem::DrawingSystem(bool boundingBoxes) :
     ISystem(),
     boundingBoxes_(boundingBoxes)
 {
 }
 
+void
+DrawingSystem::addDebugDraw(const DebugDraw &debug)
+{
+    auto l = lock();
+    if (std::find(debugDraws_.begin(), debugDraws_.end(), &debug) == debugDraws_.end()) {
+        debugDraws_.push_back(&debug);
+    }
+}
+
+void
+DrawingSystem::dropDebugDraw(const DebugDraw &debug)
+{
+    auto l = lock();
+    debugDraws_.erase(std::remove(debugDraws_.begin(), debugDraws_.end(), &debug), debugDraws_.end());
+}
+
+void
+DrawingSystem::addProperties(IEntity &entity)
+{
+    auto l = entity.lock();
+    entity.properties.add<int>("layer");
+    auto &layer = entity.properties.ref<int>("layer");
+    auto batch = dynamic_cast<const IBatchable*>(&entity);
+    added_.push_back(Item{0, &entity, batch, &layer, nullptr, 0});
+}
+
+void
+DrawingSystem::dropProperties(IEntity &entity)
+{
+    auto matches = [&entity](const Item &item) { return item.entity == &entity; };
+    queue_.erase(std::remove_if(queue_.begin(), queue_.end(), matches), queue_.end());
+    added_.erase(std::remove_if(added_.begin(), added_.end(), matches), added_.end());
+}
+
+std::uint64_t
+DrawingSystem::sortKey(Item &item) const
+{
+    auto &entity = *item.entity;
+    auto z = entity.zOrder();
+    auto l = entity.lock();
+    std::uint64_t blend = 0;
+    if (item.batch) {
+        auto texture = item.batch->getBatchTexture();
+        if (texture != item.texture) {
+            auto found = textureIDs_.emplace(texture, static_cast<std::uint32_t>(textureIDs_.size() + 1));
+            item.texture = texture;
+            item.textureID = texture ? found.first->second : 0;
+        }
+        auto mode = item.batch->getBatchBlendMode();
+        auto found = std::find(blendModes_.begin(), blendModes_.end(), mode);
+        blend = found - blendModes_.begin();
+        if (found == blendModes_.end()) {
+            blendModes_.push_back(mode);
+        }
+    }
+    return bias16(*item.layer) << 48 |
+           bias16(z) << 32 |
+           static_cast<std::uint64_t>(item.textureID & 0xffffff) << 8 |
+           (blend & 0xff);
+}
+
+void
+DrawingSystem::sortQueue() const
+{
+    changed_.clear();
+    auto kept = queue_.begin();
+    for (auto &item : queue_) {
+        auto key = sortKey(item);
+        if (key == item.key) {
+            *kept++ = item;
+        } else {
+            item.key = key;
+            changed_.push_back(item);
+        }
+    }
+    queue_.erase(kept, queue_.end());
+    for (auto &item : added_) {
+        item.key = sortKey(item);
+        changed_.push_back(item);
+    }
+    added_.clear();
+    if (changed_.empty()) {
+        return;
+    }
+
+    radixSort(changed_, scratch_);
+    scratch_.resize(queue_.size() + changed_.size());
+    std::merge(queue_.begin(), queue_.end(), changed_.begin(), changed_.end(), scratch_.begin(),
+               [](const Item &lhs, const Item &rhs) { return lhs.key < rhs.key; });
+    queue_.swap(scratch_);
+}
+
+bool
+DrawingSystem::batchable(const Drawing &drawing)
+{
+    if (!drawing.batch || drawing.entity->hasChildren()) {
+        return false;
+    }
+    auto l = drawing.entity->lock();
+    return drawing.batch->isBatchable();
+}
+
+void
+DrawingSystem::flush(sf::RenderTarget &target, const sf::RenderStates &states, Stats &stats) const
+{
+    if (vertices_.empty()) {
+        return;
+    }
+    target.draw(vertices_.data(), vertices_.size(), sf::Triangles, states);
+    vertices_.clear();
+    ++stats.batches;
+    ++stats.drawCalls;
+}
+
 void
 DrawingSystem::draw(Context &target, sf::RenderStates states) const
 {
-    std::multimap<int, IEntity*> drawings;
     if (true) {
         auto l = lock();
-        for (auto entity : entities_) {
-            drawings.insert(std::pair<int, IEntity*>(entity->zOrder(), entity));
+        sortQueue();
+        drawings_.clear();
+        for (auto &item : queue_) {
+            drawings_.push_back(Drawing{item.entity, item.batch});
         }
     }
-    for (auto &val: drawings) {
-        auto entity = val.second;
-        target.window().draw(*entity, states);
+    auto &window = target.window();
+    // Batched vertices are transformed on the CPU, states.transform included.
+    auto batch = states;
+    batch.transform = sf::Transform::Identity;
+    Stats stats;
+    for (auto &drawing : drawings_) {
+        auto entity = drawing.entity;
+        if (batchable(drawing)) {
+            auto l = entity->lock();
+            auto texture = drawing.batch->getBatchTexture();
+            auto blend = drawing.batch->getBatchBlendMode();
+            if (texture != batch.texture || blend != batch.blendMode) {
+                flush(window, batch, stats);
+                batch.texture = texture;
+                batch.blendMode = blend;
+            }
+            auto transform = states.transform * entity->getTransform();
+            drawing.batch->appendTriangles(vertices_, transform);
+            ++stats.batched;
+        } else {
+            flush(window, batch, stats);
+            window.draw(*entity, states);
+            ++stats.drawCalls;
+        }
         if (boundingBoxes_) {
-            auto bounds = entity->getGlobalBounds();
-            sf::Vector2f size(bounds.width, bounds.height);
-            sf::RectangleShape box(size);
-            box.setPosition(bounds.left, bounds.top);
-            box.setOutlineColor(sf::Color::Green);
-            box.setFillColor(sf::Color::Transparent);
-            box.setOutlineThickness(2.0f);
-            target.window().draw(box);
+            boxes_.rect(entity->getGlobalBounds(), sf::Color::Green);
         }
     }
+    flush(window, batch, stats);
+    if (boundingBoxes_) {
+        boxes_.present();
+        boxes_.draw(window);
+        ++stats.drawCalls;
+    }
+    auto l = lock();
+    for (auto debug : debugDraws_) {
+        debug->draw(window);
+        ++stats.drawCalls;
+    }
+    stats_ = stats;
 }
 
 } // namespace CompuBrite::SFML
@@ -0,0 +1,345 @@
+/**
+ * The MIT License (MIT)
+ *
+ * @copyright
+ * Copyright (c) 2020 Rich Newman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @file
+ * @brief Implementation for DynamicTree
+*/
+
+#include "CompuBrite/SFML/DynamicTree.h"
+#include "CompuBrite/CheckPoint.h"
+
+namespace CompuBrite::SFML {
+
+/// The predicted displacement is scaled by this much when fattening a moved
+/// proxy, so a steadily moving entity is reinserted only every few ticks.
+static constexpr float displacementMultiplier = 4.0f;
+
+DynamicTree::DynamicTree(float margin) :
+    margin_(margin)
+{
+}
+
+int
+DynamicTree::allocateNode()
+{
+    if (freeList_ == Null) {
+        nodes_.emplace_back();
+        return static_cast<int>(nodes_.size() - 1);
+    }
+    auto index = freeList_;
+    freeList_ = nodes_[index].parent;
+    nodes_[index] = Node();
+    return index;
+}
+
+void
+DynamicTree::freeNode(int index)
+{
+    auto &node = nodes_[index];
+    node.entity = nullptr;
+    node.height = -1;
+    node.child1 = Null;
+    node.child2 = Null;
+    node.parent = freeList_;
+    freeList_ = index;
+}
+
+int
+DynamicTree::createProxy(const AABB &aabb, IEntity *entity, std::uint32_t categories)
+{
+    auto proxy = allocateNode();
+    auto &node = nodes_[proxy];
+    const sf::Vector2f r(margin_, margin_);
+    node.aabb = AABB(aabb.lower - r, aabb.upper + r);
+    node.entity = entity;
+    node.categories = categories;
+    node.height = 0;
+    insertLeaf(proxy);
+    return proxy;
+}
+
+void
+DynamicTree::destroyProxy(int proxy)
+{
+    if (!CheckPoint::expect(CBI_HERE, proxy >= 0 && nodes_[proxy].isLeaf(),
+                            "Not a proxy")) {
+        return;
+    }
+    removeLeaf(proxy);
+    freeNode(proxy);
+}
+
+bool
+DynamicTree::moveProxy(int proxy, const AABB &aabb, const sf::Vector2f &displacement)
+{
+    const sf::Vector2f r(margin_, margin_);
+    AABB fat(aabb.lower - r, aabb.upper + r);
+
+    // Extend the fat box in the direction of motion.
+    const auto d = displacement * displacementMultiplier;
+    (d.x < 0.0f ? fat.lower.x : fat.upper.x) += d.x;
+    (d.y < 0.0f ? fat.lower.y : fat.upper.y) += d.y;
+
+    const auto &current = nodes_[proxy].aabb;
+    if (current.contains(aabb)) {
+        // Still inside its fat box, but the fat box might have become too
+        // large, (e.g. the entity stopped after moving quickly).
+        const sf::Vector2f huge(4.0f * margin_, 4.0f * margin_);
+        if (AABB(fat.lower - huge, fat.upper + huge).contains(current)) {
+            return false;
+        }
+    }
+
+    removeLeaf(proxy);
+    nodes_[proxy].aabb = fat;
+    insertLeaf(proxy);
+    return true;
+}
+
+void
+DynamicTree::setCategories(int proxy, std::uint32_t categories)
+{
+    nodes_[proxy].categories = categories;
+    for (auto index = nodes_[proxy].parent; index != Null; index = nodes_[index].parent) {
+        auto &node = nodes_[index];
+        node.categories = nodes_[node.child1].categories | nodes_[node.child2].categories;
+    }
+}
+
+int
+DynamicTree::getHeight() const
+{
+    return root_ == Null ? 0 : nodes_[root_].height;
+}
+
+void
+DynamicTree::insertLeaf(int leaf)
+{
+    if (root_ == Null) {
+        root_ = leaf;
+        nodes_[root_].parent = Null;
+        return;
+    }
+
+    // Find the best sibling for this leaf.
+    const auto leafAABB = nodes_[leaf].aabb;
+    auto index = root_;
+    while (!nodes_[index].isLeaf()) {
+        const auto &node = nodes_[index];
+        const auto area = node.aabb.perimeter();
+        const auto combinedArea = AABB::combine(node.aabb, leafAABB).perimeter();
+
+        // Cost of creating a new parent for this node and the new leaf.
+        const auto cost = 2.0f * combinedArea;
+
+        // Minimum cost of pushing the leaf further down the tree.
+        const auto inheritanceCost = 2.0f * (combinedArea - area);
+
+        auto descendCost = [&](int child) {
+            const auto &c = nodes_[child];
+            const auto combined = AABB::combine(leafAABB, c.aabb).perimeter();
+            if (c.isLeaf()) {
+                return combined + inheritanceCost;
+            }
+            return (combined - c.aabb.perimeter()) + inheritanceCost;
+        };
+        const auto cost1 = descendCost(node.child1);
+        const auto cost2 = descendCost(node.child2);
+
+        if (cost < cost1 && cost < cost2) {
+            break;
+        }
+        index = (cost1 < cost2) ? node.child1 : node.child2;
+    }
+    const auto sibling = index;
+
+    // Create a new parent for the sibling and the leaf.
+    const auto oldParent = nodes_[sibling].parent;
+    const auto newParent = allocateNode();
+    nodes_[newParent].parent = oldParent;
+    nodes_[newParent].aabb = AABB::combine(leafAABB, nodes_[sibling].aabb);
+    nodes_[newParent].categories = nodes_[leaf].categories | nodes_[sibling].categories;
+    nodes_[newParent].height = nodes_[sibling].height + 1;
+    nodes_[newParent].child1 = sibling;
+    nodes_[newParent].child2 = leaf;
+    nodes_[sibling].parent = newParent;
+    nodes_[leaf].parent = newParent;
+
+    if (oldParent == Null) {
+        root_ = newParent;
+    } else if (nodes_[oldParent].child1 == sibling) {
+        nodes_[oldParent].child1 = newParent;
+    } else {
+        nodes_[oldParent].child2 = newParent;
+    }
+
+    refit(nodes_[leaf].parent);
+}
+
+void
+DynamicTree::removeLeaf(int leaf)
+{
+    if (leaf == root_) {
+        root_ = Null;
+        return;
+    }
+
+    const auto parent = nodes_[leaf].parent;
+    const auto grandParent = nodes_[parent].parent;
+    const auto sibling = (nodes_[parent].child1 == leaf) ? nodes_[parent].child2
+                                                         : nodes_[parent].child1;
+
+    if (grandParent == Null) {
+        root_ = sibling;
+        nodes_[sibling].parent = Null;
+        freeNode(parent);
+        return;
+    }
+
+    // Destroy the parent and connect the sibling to the grandparent.
+    if (nodes_[grandParent].child1 == parent) {
+        nodes_[grandParent].child1 = sibling;
+    } else {
+        nodes_[grandParent].child2 = sibling;
+    }
+    nodes_[sibling].parent = grandParent;
+    freeNode(parent);
+
+    refit(grandParent);
+}
+
+void
+DynamicTree::refit(int index)
+{
+    while (index != Null) {
+        index = balance(index);
+        auto &node = nodes_[index];
+        const auto &child1 = nodes_[node.child1];
+        const auto &child2 = nodes_[node.child2];
+        node.height = 1 + std::max(child1.height, child2.height);
+        node.aabb = AABB::combine(child1.aabb, child2.aabb);
+        node.categories = child1.categories | child2.categories;
+        index = node.parent;
+    }
+}
+
+int
+DynamicTree::balance(int iA)
+{
+    auto &A = nodes_[iA];
+    if (A.isLeaf() || A.height < 2) {
+        return iA;
+    }
+
+    const auto iB = A.child1;
+    const auto iC = A.child2;
+    auto &B = nodes_[iB];
+    auto &C = nodes_[iC];
+
+    // Replace A with its new subtree root, (child) in A's parent.
+    auto replace = [this, &A, iA](int child) {
+        nodes_[child].parent = A.parent;
+        A.parent = child;
+        if (nodes_[child].parent == Null) {
+            root_ = child;
+        } else if (nodes_[nodes_[child].parent].child1 == iA) {
+            nodes_[nodes_[child].parent].child1 = child;
+        } else {
+            nodes_[nodes_[child].parent].child2 = child;
+        }
+    };
+
+    // Recompute the category union of a rotated node.
+    auto categories = [this](Node &node) {
+        node.categories = nodes_[node.child1].categories | nodes_[node.child2].categories;
+    };
+
+    const auto imbalance = C.height - B.height;
+
+    if (imbalance > 1) {
+        // Rotate C up.
+        const auto iF = C.child1;
+        const auto iG = C.child2;
+        auto &F = nodes_[iF];
+        auto &G = nodes_[iG];
+
+        C.child1 = iA;
+        replace(iC);
+
+        if (F.height > G.height) {
+            C.child2 = iF;
+            A.child2 = iG;
+            G.parent = iA;
+            A.aabb = AABB::combine(B.aabb, G.aabb);
+            C.aabb = AABB::combine(A.aabb, F.aabb);
+            A.height = 1 + std::max(B.height, G.height);
+            C.height = 1 + std::max(A.height, F.height);
+        } else {
+            C.child2 = iG;
+            A.child2 = iF;
+            F.parent = iA;
+            A.aabb = AABB::combine(B.aabb, F.aabb);
+            C.aabb = AABB::combine(A.aabb, G.aabb);
+            A.height = 1 + std::max(B.height, F.height);
+            C.height = 1 + std::max(A.height, G.height);
+        }
+        categories(A);
+        categories(C);
+        return iC;
+    }
+
+    if (imbalance < -1) {
+        // Rotate B up.
+        const auto iD = B.child1;
+        const auto iE = B.child2;
+        auto &D = nodes_[iD];
+        auto &E = nodes_[iE];
+
+        B.child1 = iA;
+        replace(iB);
+
+        if (D.height > E.height) {
+            B.child2 = iD;
+            A.child1 = iE;
+            E.parent = iA;
+            A.aabb = AABB::combine(C.aabb, E.aabb);
+            B.aabb = AABB::combine(A.aabb, D.aabb);
+            A.height = 1 + std::max(C.height, E.height);
+            B.height = 1 + std::max(A.height, D.height);
+        } else {
+            B.child2 = iE;
+            A.child1 = iD;
+            D.parent = iA;
+            A.aabb = AABB::combine(C.aabb, D.aabb);
+            B.aabb = AABB::combine(A.aabb, E.aabb);
+            A.height = 1 + std::max(C.height, D.height);
+            B.height = 1 + std::max(A.height, E.height);
+        }
+        categories(A);
+        categories(B);
+        return iB;
+    }
+
+    return iA;
+}
+
+} // namespace CompuBrite::SFML
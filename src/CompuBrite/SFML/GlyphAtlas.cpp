@@ -0,0 +1,122 @@
+/**
+ * The MIT License (MIT)
+ *
+ * @copyright
+ * Copyright (c) 2020 Rich Newman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @file
+ * @brief Implementation for GlyphAtlas
+*/
+
+#include "CompuBrite/SFML/GlyphAtlas.h"
+#include "CompuBrite/SFML/TextureAtlas.h"
+
+#include <SFML/Graphics/Image.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace CompuBrite::SFML {
+
+namespace {
+
+/// Empty pixels right and below each glyph, so smoothing never samples a
+/// neighbour.
+constexpr unsigned Padding = 2;
+
+} // namespace
+
+GlyphAtlas::GlyphAtlas(const sf::Font &font, unsigned int size, std::string_view characters) :
+    font_(&font),
+    size_(size)
+{
+    std::vector<std::pair<std::uint32_t, sf::IntRect>> sources;
+    for (auto c : characters) {
+        auto code = static_cast<std::uint32_t>(static_cast<unsigned char>(c));
+        if (glyphs_.count(code)) {
+            continue;
+        }
+        const auto &glyph = font.getGlyph(code, size, false);
+        glyphs_[code] = Glyph{glyph.bounds, sf::IntRect(), glyph.advance};
+        if (glyph.textureRect.width > 0 && glyph.textureRect.height > 0) {
+            sources.emplace_back(code, glyph.textureRect);
+        }
+    }
+    std::stable_sort(sources.begin(), sources.end(), [](const auto &lhs, const auto &rhs) {
+        return lhs.second.height > rhs.second.height;
+    });
+
+    // Find the smallest square texture holding every glyph.
+    auto pack = [this, &sources](unsigned side) {
+        SkylinePacker packer(side, side);
+        for (auto &[code, source] : sources) {
+            auto &rect = glyphs_[code].rect;
+            if (!packer.insert(source.width + Padding, source.height + Padding, rect)) {
+                return false;
+            }
+            rect.width = source.width;
+            rect.height = source.height;
+        }
+        return true;
+    };
+    unsigned side = 64;
+    while (!pack(side)) {
+        side *= 2;
+        if (side > sf::Texture::getMaximumSize()) {
+            throw std::runtime_error("glyphs do not fit in a texture");
+        }
+    }
+
+    // The page of the font may have been reallocated while rasterising, so it
+    // is only read once every glyph is in.
+    auto page = font.getTexture(size).copyToImage();
+    sf::Image image;
+    image.create(side, side, sf::Color(255, 255, 255, 0));
+    for (auto &[code, source] : sources) {
+        auto &rect = glyphs_[code].rect;
+        image.copy(page, rect.left, rect.top, source);
+    }
+    if (!texture_.loadFromImage(image)) {
+        throw std::runtime_error("failed to create glyph atlas");
+    }
+    texture_.setSmooth(true);
+}
+
+const GlyphAtlas::Glyph *
+GlyphAtlas::getGlyph(std::uint32_t character) const
+{
+    auto found = glyphs_.find(character);
+    return found != glyphs_.end() ? &found->second : nullptr;
+}
+
+float
+GlyphAtlas::getKerning(std::uint32_t first, std::uint32_t second) const
+{
+    return font_->getKerning(first, second, size_);
+}
+
+float
+GlyphAtlas::getLineSpacing() const
+{
+    return font_->getLineSpacing(size_);
+}
+
+} // namespace CompuBrite::SFML
@@ -27,10 +27,62 @@
 #include "CompuBrite/SFML/IEntity.h"
 #include "CompuBrite/SFML/ISystem.h"
 
+#include <SFML/Graphics/RenderTexture.hpp>
+#include <SFML/Graphics/Vertex.hpp>
+
+#include <cmath>
 #include <map>
 
 namespace CompuBrite::SFML {
 
+struct IEntity::Cache
+{
+    sf::RenderTexture texture;
+    sf::FloatRect bounds;
+    std::atomic<bool> dirty{true};
+};
+
+namespace {
+
+/// @return The smallest rectangle holding both rectangles.  Empty rectangles
+/// are ignored.
+sf::FloatRect
+unite(const sf::FloatRect &lhs, const sf::FloatRect &rhs)
+{
+    if (lhs.width <= 0.0f && lhs.height <= 0.0f) {
+        return rhs;
+    }
+    if (rhs.width <= 0.0f && rhs.height <= 0.0f) {
+        return lhs;
+    }
+    auto left = std::min(lhs.left, rhs.left);
+    auto top = std::min(lhs.top, rhs.top);
+    auto right = std::max(lhs.left + lhs.width, rhs.left + rhs.width);
+    auto bottom = std::max(lhs.top + lhs.height, rhs.top + rhs.height);
+    return sf::FloatRect(left, top, right - left, bottom - top);
+}
+
+} // namespace
+
+IEntity::IEntity() = default;
+
+IEntity::IEntity(int zOrder) :
+    zOrder_(zOrder)
+{
+}
+
+IEntity::~IEntity()
+{
+    journal().forget(*this);
+}
+
+TransformJournal&
+IEntity::journal()
+{
+    static TransformJournal journal;
+    return journal;
+}
+
 sf::FloatRect
 IEntity::getLocalBounds() const
 {
@@ -41,6 +93,10 @@ void
 IEntity::draw(sf::RenderTarget &target, sf::RenderStates states) const
 {
     states.transform *= this->getTransform();
+    if (cache_) {
+        drawCached(target, states);
+        return;
+    }
     if (true) {
         auto l = lock();
         drawThis(target, states);
@@ -48,6 +104,106 @@ IEntity::draw(sf::RenderTarget &target, sf::RenderStates states) const
     drawChildren(target, states);
 }
 
+void
+IEntity::drawCached(sf::RenderTarget &target, sf::RenderStates states) const
+{
+    auto &cache = *cache_;
+    if (cache.dirty.exchange(false)) {
+        cache.bounds = getSubtreeBounds();
+        auto width = static_cast<unsigned>(std::ceil(cache.bounds.width));
+        auto height = static_cast<unsigned>(std::ceil(cache.bounds.height));
+        if (width == 0 || height == 0) {
+            // Nothing to draw, and no texture to draw into.
+            cache.bounds = sf::FloatRect();
+            return;
+        }
+        auto size = cache.texture.getSize();
+        if (size.x < width || size.y < height) {
+            cache.texture.create(std::max(size.x, width), std::max(size.y, height));
+        }
+        cache.texture.clear(sf::Color::Transparent);
+        sf::RenderStates local;
+        local.transform.translate(-cache.bounds.left, -cache.bounds.top);
+        if (true) {
+            auto l = lock();
+            drawThis(cache.texture, local);
+        }
+        drawChildren(cache.texture, local);
+        cache.texture.display();
+    }
+
+    // The texture holds colours already multiplied by their alpha.
+    auto &bounds = cache.bounds;
+    if (bounds.width <= 0.0f || bounds.height <= 0.0f) {
+        return;
+    }
+    sf::Vertex quad[4] = {
+        sf::Vertex({bounds.left, bounds.top}, {0.0f, 0.0f}),
+        sf::Vertex({bounds.left, bounds.top + bounds.height}, {0.0f, bounds.height}),
+        sf::Vertex({bounds.left + bounds.width, bounds.top}, {bounds.width, 0.0f}),
+        sf::Vertex({bounds.left + bounds.width, bounds.top + bounds.height}, {bounds.width, bounds.height}),
+    };
+    states.texture = &cache.texture.getTexture();
+    states.blendMode = sf::BlendMode(sf::BlendMode::One, sf::BlendMode::OneMinusSrcAlpha);
+    target.draw(quad, 4, sf::TriangleStrip, states);
+}
+
+void
+IEntity::setCached(bool cached)
+{
+    auto l = lock();
+    if (!cached) {
+        cache_.reset();
+    } else if (!cache_) {
+        cache_ = std::make_unique<Cache>();
+    }
+}
+
+bool
+IEntity::isCached() const
+{
+    auto l = lock();
+    return cache_ != nullptr;
+}
+
+void
+IEntity::invalidate()
+{
+    for (auto entity = this; entity; entity = entity->parent_) {
+        if (entity->cache_) {
+            entity->cache_->dirty = true;
+        }
+    }
+}
+
+void
+IEntity::reshaped()
+{
+    shapeVersion_.fetch_add(1, std::memory_order_relaxed);
+    invalidate();
+}
+
+sf::FloatRect
+IEntity::getSubtreeBounds() const
+{
+    Children children;
+    auto bounds = sf::FloatRect();
+    if (true) {
+        auto l = lock();
+        bounds = getLocalBounds();
+        children = children_;
+    }
+    for (auto child : children) {
+        auto transform = sf::Transform::Identity;
+        if (true) {
+            auto l = child->lock();
+            transform = child->getTransform();
+        }
+        bounds = unite(bounds, transform.transformRect(child->getSubtreeBounds()));
+    }
+    return bounds;
+}
+
 void
 IEntity::drawChildren(sf::RenderTarget &target, sf::RenderStates states) const
 {
@@ -76,6 +232,11 @@ IEntity::addChild(IEntity &child)
     children_.push_back(&child);
     auto l2 = child.lock();
     child.parent_ = this;
+    l2.unlock();
+    l.unlock();
+    // The global transform of the child changed along with its parent.
+    journal().record(child);
+    invalidate();
     return true;
 }
 
@@ -173,5 +334,111 @@ IEntity::getGlobalBounds() const
     return transform.transformRect(getLocalBounds());
 }
 
+void
+IEntity::transformed()
+{
+    journal().record(*this);
+    if (auto parent = parent_.load()) {
+        parent->invalidate();
+    }
+}
+
+void
+IEntity::setPosition(float x, float y)
+{
+    setPosition(sf::Vector2f(x, y));
+}
+
+void
+IEntity::setPosition(const sf::Vector2f &position)
+{
+    if (position != getPosition()) {
+        sf::Transformable::setPosition(position);
+        transformed();
+    }
+}
+
+void
+IEntity::setRotation(float angle)
+{
+    // Compare the angle as sf::Transformable will store it.
+    auto normal = std::fmod(angle, 360.0f);
+    if (normal < 0.0f) {
+        normal += 360.0f;
+    }
+    if (normal != getRotation()) {
+        sf::Transformable::setRotation(angle);
+        transformed();
+    }
+}
+
+void
+IEntity::setScale(float factorX, float factorY)
+{
+    setScale(sf::Vector2f(factorX, factorY));
+}
+
+void
+IEntity::setScale(const sf::Vector2f &factors)
+{
+    if (factors != getScale()) {
+        sf::Transformable::setScale(factors);
+        transformed();
+    }
+}
+
+void
+IEntity::setOrigin(float x, float y)
+{
+    setOrigin(sf::Vector2f(x, y));
+}
+
+void
+IEntity::setOrigin(const sf::Vector2f &origin)
+{
+    if (origin != getOrigin()) {
+        sf::Transformable::setOrigin(origin);
+        transformed();
+    }
+}
+
+void
+IEntity::move(float offsetX, float offsetY)
+{
+    move(sf::Vector2f(offsetX, offsetY));
+}
+
+void
+IEntity::move(const sf::Vector2f &offset)
+{
+    if (offset != sf::Vector2f()) {
+        sf::Transformable::move(offset);
+        transformed();
+    }
+}
+
+void
+IEntity::rotate(float angle)
+{
+    if (angle != 0.0f) {
+        sf::Transformable::rotate(angle);
+        transformed();
+    }
+}
+
+void
+IEntity::scale(float factorX, float factorY)
+{
+    scale(sf::Vector2f(factorX, factorY));
+}
+
+void
+IEntity::scale(const sf::Vector2f &factor)
+{
+    if (factor != sf::Vector2f(1.0f, 1.0f)) {
+        sf::Transformable::scale(factor);
+        transformed();
+    }
+}
 
 } // namespace CompuBrite::SFML
@@ -30,94 +30,175 @@
 
 namespace CompuBrite::SFML {
 
-IShapeEntity::IShapeEntity(sf::Shape &shape) :
-    shape_(&shape)
+IShapeEntity::IShapeEntity() :
+    geometry_(ShapeGeometry::share({}, 0.0f))
 {
-    //ctor
+}
+
+void
+IShapeEntity::setPoints(const ShapeGeometry::Points &points)
+{
+    points_ = points;
+    stale_ = true;
+    reshaped();
+}
+
+ShapeGeometry::Points &
+IShapeEntity::editPoints()
+{
+    stale_ = true;
+    reshaped();
+    return points_;
+}
+
+const ShapeGeometry &
+IShapeEntity::geometry() const
+{
+    if (stale_) {
+        geometry_ = ShapeGeometry::share(points_, geometry_->getOutlineThickness());
+        stale_ = false;
+    }
+    return *geometry_;
 }
 
 void
 IShapeEntity::setTexture(const sf::Texture *texture, bool resetRect)
 {
-    shape_->setTexture(texture, resetRect);
+    if (texture && (resetRect || (!texture_ && textureRect_ == sf::IntRect()))) {
+        auto size = texture->getSize();
+        textureRect_ = sf::IntRect(0, 0, size.x, size.y);
+    }
+    texture_ = texture;
+    invalidate();
 }
 
 void
 IShapeEntity::setTextureRect(const sf::IntRect &rectangle)
 {
-    shape_->setTextureRect(rectangle);
+    textureRect_ = rectangle;
+    invalidate();
 }
 
 void
 IShapeEntity::setFillColor(const sf::Color &color)
 {
-    shape_ ->setFillColor(color);
+    fillColor_ = color;
+    invalidate();
 }
 
 void
 IShapeEntity::setOutlineColor(const sf::Color &color)
 {
-    shape_ ->setOutlineColor(color);
+    outlineColor_ = color;
+    invalidate();
 }
 
 void
 IShapeEntity::setOutlineThickness(float thickness)
 {
-    shape_->setOutlineThickness(thickness);
+    geometry_ = ShapeGeometry::share(points_, thickness);
+    stale_ = false;
+    invalidate();
 }
 
 const sf::Texture *
 IShapeEntity::getTexture() const
 {
-    return shape_->getTexture();
+    return texture_;
 }
 
 const sf::IntRect &
 IShapeEntity::getTextureRect() const
 {
-    return shape_->getTextureRect();
+    return textureRect_;
 }
 
 const sf::Color &
 IShapeEntity::getFillColor() const
 {
-    return shape_->getFillColor();
+    return fillColor_;
 }
 
 const sf::Color &
 IShapeEntity::getOutlineColor() const
 {
-    return shape_->getOutlineColor();
+    return outlineColor_;
 }
 
 float
 IShapeEntity::getOutlineThickness() const
 {
-    return shape_->getOutlineThickness();
+    return geometry_->getOutlineThickness();
 }
 
 std::size_t
 IShapeEntity::getPointCount() const
 {
-    return shape_->getPointCount();
+    return points_.size();
 }
 
 sf::Vector2f
 IShapeEntity::getPoint(std::size_t index) const
 {
-    return shape_->getPoint(index);
+    return points_[index];
+}
+
+bool
+IShapeEntity::isBatchable() const
+{
+    return !texture_ || geometry().getOutline().empty();
+}
+
+const sf::Texture *
+IShapeEntity::getBatchTexture() const
+{
+    return texture_;
+}
+
+void
+IShapeEntity::append(std::vector<sf::Vertex> &vertices, const ShapeGeometry::Vertices &geometry,
+                     const sf::Transform &transform, const sf::Color &color, bool textured) const
+{
+    sf::Vector2f origin(textureRect_.left, textureRect_.top);
+    sf::Vector2f size(textureRect_.width, textureRect_.height);
+    for (auto &vertex : geometry) {
+        sf::Vector2f texCoords;
+        if (textured) {
+            texCoords = sf::Vector2f(origin.x + size.x * vertex.texCoords.x,
+                                     origin.y + size.y * vertex.texCoords.y);
+        }
+        vertices.emplace_back(transform.transformPoint(vertex.position), color, texCoords);
+    }
+}
+
+void
+IShapeEntity::appendTriangles(std::vector<sf::Vertex> &vertices, const sf::Transform &transform) const
+{
+    append(vertices, geometry().getFill(), transform, fillColor_, texture_ != nullptr);
+    append(vertices, geometry().getOutline(), transform, outlineColor_, false);
 }
 
 void
 IShapeEntity::drawThis(sf::RenderTarget &target, sf::RenderStates states) const
 {
-    target.draw(*shape_, states);
+    thread_local std::vector<sf::Vertex> vertices;
+    vertices.clear();
+    append(vertices, geometry().getFill(), sf::Transform::Identity, fillColor_, texture_ != nullptr);
+    states.texture = texture_;
+    target.draw(vertices.data(), vertices.size(), sf::Triangles, states);
+
+    if (!geometry().getOutline().empty()) {
+        vertices.clear();
+        append(vertices, geometry().getOutline(), sf::Transform::Identity, outlineColor_, false);
+        states.texture = nullptr;
+        target.draw(vertices.data(), vertices.size(), sf::Triangles, states);
+    }
 }
 
 sf::FloatRect
 IShapeEntity::getLocalBounds() const
 {
-    return shape_->getLocalBounds();
+    return geometry().getBounds();
 }
 
 } // namespace CompuBrite::SFML
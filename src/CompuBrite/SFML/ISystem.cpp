@@ -62,6 +62,7 @@ ISystem::dropEntity(IEntity &entity, bool callback)
     Lock lock(mutex_);
     auto found = std::find(entities_.begin(), entities_.end(), &entity);
     if (found != entities_.end()) {
+        dropProperties(entity);
         entities_.erase(found);
         lock.unlock();
         if (callback) {
@@ -75,4 +76,9 @@ ISystem::addProperties(IEntity &)
 {
 }
 
+void
+ISystem::dropProperties(IEntity &)
+{
+}
+
 } // namespace CompuBrite::SFML
@@ -28,9 +28,18 @@
 
 #include <SFML/System/Vector2.hpp>
 #include <CompuBrite/SFML/Context.h>
+#include <CompuBrite/SFML/TaskBatch.h>
+
+#include <algorithm>
+#include <memory>
+#include <thread>
 
 namespace CompuBrite::SFML {
 
+/// Below this many entities per thread, an update is not worth splitting
+/// across the ThreadPool.
+static constexpr std::size_t entitiesPerThread = 64;
+
 void
 MovementSystem::update(Context &target, sf::Time dt)
 {
@@ -38,20 +47,38 @@ MovementSystem::update(Context &target, sf::Time dt)
     auto temp = this->entities_;
     lock.unlock();
 
-    for (auto entity: temp) {
-        target.addTask([entity, dt]() {
+    auto t = dt.asSeconds();
+    auto move = [&temp, t](std::size_t chunk, std::size_t chunks) {
+        auto end = temp.size() * (chunk + 1) / chunks;
+        for (auto i = temp.size() * chunk / chunks; i < end; ++i) {
+            auto entity = temp[i];
             auto lock = entity->lock();
             auto &vel = entity->properties.ref<sf::Vector2f>("velocity");
             auto &rot = entity->properties.ref<float>("rotation");
             auto acc = entity->properties.get<sf::Vector2f>("acceleration");
             auto racc = entity->properties.get<float>("rot_accel");
-            auto t = dt.asSeconds();
             vel += acc * t;
             rot += racc * t;
             entity->move(vel * t);
             entity->rotate(rot * t);
-        });
+        }
+    };
+
+    // Every entity is moved before returning, so the moves are journaled in
+    // this tick rather than the next.
+    const auto threads = std::max(1u, std::thread::hardware_concurrency());
+    const auto chunks = std::clamp<std::size_t>(temp.size() / entitiesPerThread, 1, threads);
+    if (chunks == 1) {
+        move(0, 1);
+        return;
+    }
+    auto batch = std::make_shared<TaskBatch>(chunks);
+    auto work = [&move, chunks](std::size_t chunk) { move(chunk, chunks); };
+    for (std::size_t helper = 1; helper < chunks; ++helper) {
+        target.addTask([batch, work] { batch->run(work); });
     }
+    batch->run(work);
+    batch->wait();
 }
 
 void
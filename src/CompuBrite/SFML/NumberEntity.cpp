@@ -0,0 +1,191 @@
+/**
+ * The MIT License (MIT)
+ *
+ * @copyright
+ * Copyright (c) 2020 Rich Newman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @file
+ * @brief Implementation for NumberEntity
+*/
+
+#include "CompuBrite/SFML/NumberEntity.h"
+
+#include <SFML/Graphics/RenderTarget.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+
+namespace CompuBrite::SFML {
+
+NumberEntity::NumberEntity(const sf::Font &font, unsigned int size, std::string_view prefix,
+                           std::string_view suffix, int precision, int width) :
+    font_(&font),
+    size_(size),
+    prefix_(prefix),
+    suffix_(suffix),
+    precision_(precision),
+    width_(width)
+{
+    vertices_.reserve(Capacity * 6);
+    refresh();
+}
+
+void
+NumberEntity::setValue(double value)
+{
+    value_ = value;
+    refresh();
+}
+
+void
+NumberEntity::setPrefix(std::string_view prefix)
+{
+    prefix_ = prefix;
+    refresh();
+}
+
+void
+NumberEntity::setSuffix(std::string_view suffix)
+{
+    suffix_ = suffix;
+    refresh();
+}
+
+void
+NumberEntity::setPrecision(int precision)
+{
+    precision_ = precision;
+    refresh();
+}
+
+void
+NumberEntity::setFillColor(const sf::Color &color)
+{
+    color_ = color;
+    for (auto &vertex : vertices_) {
+        vertex.color = color;
+    }
+    invalidate();
+}
+
+sf::FloatRect
+NumberEntity::getLocalBounds() const
+{
+    return bounds_;
+}
+
+void
+NumberEntity::refresh()
+{
+    std::array<char, Capacity> number;
+    auto written = std::snprintf(number.data(), number.size(), "%.*f", precision_, value_);
+    auto digits = written > 0 ? std::min(static_cast<std::size_t>(written), number.size() - 1) : 0;
+
+    std::array<char, Capacity> next;
+    std::size_t length = 0;
+    auto append = [&next, &length](const char *text, std::size_t count) {
+        count = std::min(count, Capacity - length);
+        std::copy_n(text, count, next.data() + length);
+        length += count;
+    };
+    append(prefix_.data(), prefix_.size());
+    for (auto pad = width_ - static_cast<int>(digits); pad > 0 && length < Capacity; --pad) {
+        next[length++] = ' ';
+    }
+    append(number.data(), digits);
+    append(suffix_.data(), suffix_.size());
+
+    auto shorter = std::min(length, length_);
+    auto from = static_cast<std::size_t>(
+        std::mismatch(next.begin(), next.begin() + shorter, text_.begin()).first - next.begin());
+    if (from == shorter && length == length_) {
+        return;
+    }
+    std::copy_n(next.begin() + from, length - from, text_.begin() + from);
+    length_ = length;
+    layout(from);
+    invalidate();
+}
+
+void
+NumberEntity::layout(std::size_t from)
+{
+    vertices_.resize(length_ * 6);
+    auto baseline = static_cast<float>(size_);
+    auto pen = pens_[from];
+    for (auto i = from; i < length_; ++i) {
+        auto c = static_cast<unsigned char>(text_[i]);
+        if (i > 0) {
+            pen += font_->getKerning(static_cast<unsigned char>(text_[i - 1]), c, size_);
+        }
+        const auto &glyph = font_->getGlyph(c, size_, false);
+        auto left = pen + glyph.bounds.left;
+        auto top = baseline + glyph.bounds.top;
+        auto right = left + glyph.bounds.width;
+        auto bottom = top + glyph.bounds.height;
+        auto u1 = static_cast<float>(glyph.textureRect.left);
+        auto v1 = static_cast<float>(glyph.textureRect.top);
+        auto u2 = u1 + glyph.textureRect.width;
+        auto v2 = v1 + glyph.textureRect.height;
+
+        auto quad = &vertices_[i * 6];
+        quad[0] = sf::Vertex({left, top}, color_, {u1, v1});
+        quad[1] = sf::Vertex({right, top}, color_, {u2, v1});
+        quad[2] = sf::Vertex({left, bottom}, color_, {u1, v2});
+        quad[3] = quad[2];
+        quad[4] = quad[1];
+        quad[5] = sf::Vertex({right, bottom}, color_, {u2, v2});
+
+        pen += glyph.advance;
+        pens_[i + 1] = pen;
+    }
+
+    bounds_ = sf::FloatRect();
+    auto minX = std::numeric_limits<float>::max();
+    auto minY = minX;
+    auto maxX = std::numeric_limits<float>::lowest();
+    auto maxY = maxX;
+    for (std::size_t i = 0; i < vertices_.size(); i += 6) {
+        auto &topLeft = vertices_[i].position;
+        auto &bottomRight = vertices_[i + 5].position;
+        if (topLeft.x == bottomRight.x) {
+            continue;
+        }
+        minX = std::min(minX, topLeft.x);
+        minY = std::min(minY, topLeft.y);
+        maxX = std::max(maxX, bottomRight.x);
+        maxY = std::max(maxY, bottomRight.y);
+    }
+    if (maxX > minX && maxY > minY) {
+        bounds_ = sf::FloatRect(minX, minY, maxX - minX, maxY - minY);
+    }
+}
+
+void
+NumberEntity::drawThis(sf::RenderTarget &target, sf::RenderStates states) const
+{
+    if (vertices_.empty()) {
+        return;
+    }
+    states.texture = &font_->getTexture(size_);
+    target.draw(vertices_.data(), vertices_.size(), sf::Triangles, states);
+}
+
+} // namespace CompuBrite::SFML
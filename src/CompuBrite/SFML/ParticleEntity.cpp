@@ -0,0 +1,297 @@
+/**
+ * The MIT License (MIT)
+ *
+ * @copyright
+ * Copyright (c) 2020 Rich Newman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @file
+ * @brief Implementation for ParticleEntity
+*/
+
+#include "CompuBrite/SFML/ParticleEntity.h"
+#include "CompuBrite/SFML/Context.h"
+#include "CompuBrite/SFML/TaskBatch.h"
+
+#include <SFML/Graphics/RenderTarget.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <thread>
+
+namespace CompuBrite::SFML {
+
+namespace {
+
+/// Below this many particles per thread, an update is not worth splitting
+/// across the ThreadPool.
+constexpr std::size_t particlesPerThread = 4096;
+
+constexpr float degrees = 3.14159265f / 180.0f;
+
+/// @return The colour t of the way from start to end.
+sf::Color
+mix(const sf::Color &start, const sf::Color &end, float t)
+{
+    auto channel = [t](sf::Uint8 lhs, sf::Uint8 rhs) {
+        return static_cast<sf::Uint8>(lhs + (static_cast<float>(rhs) - lhs) * t);
+    };
+    return sf::Color(channel(start.r, end.r), channel(start.g, end.g),
+                     channel(start.b, end.b), channel(start.a, end.a));
+}
+
+} // namespace
+
+ParticleEntity::ParticleEntity(std::size_t capacity, const ParticleEmitter &emitter, int zOrder) :
+    IEntity(zOrder),
+    capacity_(capacity),
+    emitter_(emitter),
+    random_(std::random_device()()),
+    x_(capacity),
+    y_(capacity),
+    vx_(capacity),
+    vy_(capacity),
+    age_(capacity),
+    life_(capacity)
+{
+    // Reserve every vertex now, so updates never allocate.
+    vertices_.resize(capacity * 6);
+    vertices_.clear();
+}
+
+void
+ParticleEntity::setEmitter(const ParticleEmitter &emitter)
+{
+    emitter_ = emitter;
+}
+
+void
+ParticleEntity::setEmitting(bool emitting)
+{
+    if (emitting != emitting_) {
+        emitting_ = emitting;
+        pending_ = 0.0f;
+    }
+}
+
+void
+ParticleEntity::burst(std::size_t count)
+{
+    emit(count);
+}
+
+void
+ParticleEntity::clear()
+{
+    count_ = 0;
+    vertices_.clear();
+    bounds_ = sf::FloatRect();
+    invalidate();
+}
+
+void
+ParticleEntity::setAcceleration(const sf::Vector2f &acceleration)
+{
+    acceleration_ = acceleration;
+}
+
+void
+ParticleEntity::setTexture(const sf::Texture *texture)
+{
+    texture_ = texture;
+    invalidate();
+}
+
+void
+ParticleEntity::setBlendMode(const sf::BlendMode &mode)
+{
+    blend_ = mode;
+    invalidate();
+}
+
+void
+ParticleEntity::setContext(Context *context)
+{
+    context_ = context;
+}
+
+sf::FloatRect
+ParticleEntity::getLocalBounds() const
+{
+    return bounds_;
+}
+
+void
+ParticleEntity::reap(float dt)
+{
+    for (std::size_t i = 0; i < count_;) {
+        if (age_[i] + dt < life_[i]) {
+            ++i;
+            continue;
+        }
+        // Move the last particle into the hole.
+        --count_;
+        x_[i] = x_[count_];
+        y_[i] = y_[count_];
+        vx_[i] = vx_[count_];
+        vy_[i] = vy_[count_];
+        age_[i] = age_[count_];
+        life_[i] = life_[count_];
+    }
+}
+
+void
+ParticleEntity::emit(std::size_t count)
+{
+    count = std::min(count, capacity_ - count_);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    auto pick = [this, &unit](float min, float max) { return min + (max - min) * unit(random_); };
+    for (; count > 0; --count, ++count_) {
+        auto i = count_;
+        auto heading = pick(emitter_.direction - emitter_.angle / 2.0f,
+                            emitter_.direction + emitter_.angle / 2.0f) * degrees;
+        auto speed = pick(emitter_.minSpeed, emitter_.maxSpeed);
+        x_[i] = emitter_.position.x + pick(-emitter_.spread.x, emitter_.spread.x);
+        y_[i] = emitter_.position.y + pick(-emitter_.spread.y, emitter_.spread.y);
+        vx_[i] = std::cos(heading) * speed;
+        vy_[i] = std::sin(heading) * speed;
+        age_[i] = 0.0f;
+        life_[i] = pick(emitter_.minLife, emitter_.maxLife);
+    }
+}
+
+sf::FloatRect
+ParticleEntity::integrate(std::size_t begin, std::size_t end, float dt)
+{
+    // Plain loops over separate arrays, which the compiler vectorises.
+    auto *x = x_.data();
+    auto *y = y_.data();
+    auto *vx = vx_.data();
+    auto *vy = vy_.data();
+    auto *age = age_.data();
+    const auto *life = life_.data();
+    const auto ax = acceleration_.x * dt;
+    const auto ay = acceleration_.y * dt;
+    for (auto i = begin; i < end; ++i) {
+        vx[i] += ax;
+        vy[i] += ay;
+        x[i] += vx[i] * dt;
+        y[i] += vy[i] * dt;
+        age[i] += dt;
+    }
+
+    sf::Vector2f texture;
+    if (texture_) {
+        texture = sf::Vector2f(texture_->getSize());
+    }
+    auto minX = std::numeric_limits<float>::max();
+    auto minY = minX;
+    auto maxX = std::numeric_limits<float>::lowest();
+    auto maxY = maxX;
+    auto *quad = &vertices_[begin * 6];
+    for (auto i = begin; i < end; ++i, quad += 6) {
+        auto t = std::min(age[i] / life[i], 1.0f);
+        auto half = (emitter_.startSize + (emitter_.endSize - emitter_.startSize) * t) / 2.0f;
+        auto color = mix(emitter_.startColor, emitter_.endColor, t);
+        auto left = x[i] - half;
+        auto top = y[i] - half;
+        auto right = x[i] + half;
+        auto bottom = y[i] + half;
+        quad[0] = sf::Vertex({left, top}, color, {0.0f, 0.0f});
+        quad[1] = sf::Vertex({right, top}, color, {texture.x, 0.0f});
+        quad[2] = sf::Vertex({left, bottom}, color, {0.0f, texture.y});
+        quad[3] = quad[2];
+        quad[4] = quad[1];
+        quad[5] = sf::Vertex({right, bottom}, color, texture);
+        minX = std::min(minX, left);
+        minY = std::min(minY, top);
+        maxX = std::max(maxX, right);
+        maxY = std::max(maxY, bottom);
+    }
+    if (maxX < minX || maxY < minY) {
+        return sf::FloatRect();
+    }
+    return sf::FloatRect(minX, minY, maxX - minX, maxY - minY);
+}
+
+void
+ParticleEntity::updateThis(sf::Time dt)
+{
+    auto seconds = dt.asSeconds();
+    auto alive = count_;
+    reap(seconds);
+    if (emitting_) {
+        pending_ += emitter_.rate * seconds;
+        auto owed = std::floor(pending_);
+        pending_ -= owed;
+        emit(static_cast<std::size_t>(owed));
+    }
+    vertices_.resize(count_ * 6);
+    if (count_ == 0) {
+        bounds_ = sf::FloatRect();
+        if (alive) {
+            invalidate();
+        }
+        return;
+    }
+
+    const auto threads = std::max(1u, std::thread::hardware_concurrency());
+    const auto chunks = context_ ? std::clamp<std::size_t>(count_ / particlesPerThread, 1, threads) : 1;
+    if (chunks == 1) {
+        bounds_ = integrate(0, count_, seconds);
+    } else {
+        chunkBounds_.resize(chunks);
+        auto work = [this, seconds, chunks](std::size_t chunk) {
+            chunkBounds_[chunk] = integrate(count_ * chunk / chunks, count_ * (chunk + 1) / chunks, seconds);
+        };
+        auto batch = std::make_shared<TaskBatch>(chunks);
+        for (std::size_t helper = 1; helper < chunks; ++helper) {
+            context_->addTask([batch, work] { batch->run(work); });
+        }
+        batch->run(work);
+        batch->wait();
+
+        auto left = std::numeric_limits<float>::max();
+        auto top = left;
+        auto right = std::numeric_limits<float>::lowest();
+        auto bottom = right;
+        for (auto &rect : chunkBounds_) {
+            left = std::min(left, rect.left);
+            top = std::min(top, rect.top);
+            right = std::max(right, rect.left + rect.width);
+            bottom = std::max(bottom, rect.top + rect.height);
+        }
+        bounds_ = sf::FloatRect(left, top, right - left, bottom - top);
+    }
+    invalidate();
+}
+
+void
+ParticleEntity::drawThis(sf::RenderTarget &target, sf::RenderStates states) const
+{
+    if (vertices_.getVertexCount() == 0) {
+        return;
+    }
+    states.texture = texture_;
+    states.blendMode = blend_;
+    target.draw(vertices_, states);
+}
+
+} // namespace CompuBrite::SFML
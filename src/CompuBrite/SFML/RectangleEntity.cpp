@@ -28,22 +28,22 @@
 
 namespace CompuBrite::SFML {
 
-RectangleEntity::RectangleEntity(const sf::Vector2f &size) :
-    IShapeEntity(rectangle_),
-    rectangle_(size)
+RectangleEntity::RectangleEntity(const sf::Vector2f &size)
 {
+    setSize(size);
 }
 
 void
 RectangleEntity::setSize(const sf::Vector2f &size)
 {
-    rectangle_.setSize(size);
+    size_ = size;
+    setPoints({{0.0f, 0.0f}, {size.x, 0.0f}, size, {0.0f, size.y}});
 }
 
 const sf::Vector2f &
 RectangleEntity::getSize() const
 {
-    return rectangle_.getSize();
+    return size_;
 }
 
 } // namespace CompuBrite::SFML
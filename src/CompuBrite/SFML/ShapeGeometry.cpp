@@ -0,0 +1,211 @@
+/**
+ * The MIT License (MIT)
+ *
+ * @copyright
+ * Copyright (c) 2020 Rich Newman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @file
+ * @brief Implementation for ShapeGeometry
+*/
+
+#include "CompuBrite/SFML/ShapeGeometry.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+
+namespace CompuBrite::SFML {
+
+namespace {
+
+using Key = std::vector<float>;
+
+/// Every geometry in use, by thickness and points.  Entries are removed by
+/// the deleter of the geometry when the last shape using it lets go.
+struct Registry
+{
+    std::mutex mutex;
+    std::map<Key, std::weak_ptr<const ShapeGeometry>> geometries;
+};
+
+Registry&
+registry()
+{
+    static Registry registry;
+    return registry;
+}
+
+sf::Vector2f
+normal(const sf::Vector2f &p1, const sf::Vector2f &p2)
+{
+    sf::Vector2f normal(p1.y - p2.y, p2.x - p1.x);
+    auto length = std::sqrt(normal.x * normal.x + normal.y * normal.y);
+    if (length != 0.0f) {
+        normal /= length;
+    }
+    return normal;
+}
+
+float
+dot(const sf::Vector2f &lhs, const sf::Vector2f &rhs)
+{
+    return lhs.x * rhs.x + lhs.y * rhs.y;
+}
+
+sf::FloatRect
+boundsOf(const ShapeGeometry::Vertices &vertices)
+{
+    if (vertices.empty()) {
+        return sf::FloatRect();
+    }
+    auto left = vertices[0].position.x;
+    auto top = vertices[0].position.y;
+    auto right = left;
+    auto bottom = top;
+    for (auto &vertex : vertices) {
+        left = std::min(left, vertex.position.x);
+        top = std::min(top, vertex.position.y);
+        right = std::max(right, vertex.position.x);
+        bottom = std::max(bottom, vertex.position.y);
+    }
+    return sf::FloatRect(left, top, right - left, bottom - top);
+}
+
+} // namespace
+
+ShapeGeometry::Ptr
+ShapeGeometry::share(const Points &points, float outlineThickness)
+{
+    Key key;
+    key.reserve(points.size() * 2 + 1);
+    key.push_back(outlineThickness);
+    for (auto &point : points) {
+        key.push_back(point.x);
+        key.push_back(point.y);
+    }
+
+    auto &shared = registry();
+    std::lock_guard<std::mutex> l(shared.mutex);
+    auto &entry = shared.geometries[key];
+    if (auto geometry = entry.lock(); geometry) {
+        return geometry;
+    }
+    Ptr geometry(new ShapeGeometry(points, outlineThickness), [key](const ShapeGeometry *geometry) {
+        auto &shared = registry();
+        if (true) {
+            std::lock_guard<std::mutex> l(shared.mutex);
+            auto found = shared.geometries.find(key);
+            if (found != shared.geometries.end() && found->second.expired()) {
+                shared.geometries.erase(found);
+            }
+        }
+        delete geometry;
+    });
+    entry = geometry;
+    return geometry;
+}
+
+std::size_t
+ShapeGeometry::getSharedCount()
+{
+    auto &shared = registry();
+    std::lock_guard<std::mutex> l(shared.mutex);
+    return shared.geometries.size();
+}
+
+ShapeGeometry::ShapeGeometry(const Points &points, float outlineThickness) :
+    points_(points),
+    thickness_(outlineThickness)
+{
+    if (points_.size() < 3) {
+        return;
+    }
+    makeFill();
+    makeOutline();
+    bounds_ = outline_.empty() ? insideBounds_ : boundsOf(outline_);
+}
+
+void
+ShapeGeometry::makeFill()
+{
+    auto left = points_[0].x;
+    auto top = points_[0].y;
+    auto right = left;
+    auto bottom = top;
+    for (auto &point : points_) {
+        left = std::min(left, point.x);
+        top = std::min(top, point.y);
+        right = std::max(right, point.x);
+        bottom = std::max(bottom, point.y);
+    }
+    insideBounds_ = sf::FloatRect(left, top, right - left, bottom - top);
+
+    auto width = insideBounds_.width > 0.0f ? insideBounds_.width : 1.0f;
+    auto height = insideBounds_.height > 0.0f ? insideBounds_.height : 1.0f;
+    auto vertex = [&](const sf::Vector2f &position) {
+        return sf::Vertex(position, sf::Vector2f((position.x - left) / width, (position.y - top) / height));
+    };
+    sf::Vector2f center(left + insideBounds_.width / 2.0f, top + insideBounds_.height / 2.0f);
+    auto count = points_.size();
+    fill_.reserve(count * 3);
+    for (std::size_t i = 0; i < count; ++i) {
+        fill_.push_back(vertex(center));
+        fill_.push_back(vertex(points_[i]));
+        fill_.push_back(vertex(points_[(i + 1) % count]));
+    }
+}
+
+void
+ShapeGeometry::makeOutline()
+{
+    if (thickness_ == 0.0f) {
+        return;
+    }
+    sf::Vector2f center(insideBounds_.left + insideBounds_.width / 2.0f,
+                        insideBounds_.top + insideBounds_.height / 2.0f);
+    auto count = points_.size();
+    std::vector<sf::Vector2f> outer(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        auto &p0 = points_[(i + count - 1) % count];
+        auto &p1 = points_[i];
+        auto &p2 = points_[(i + 1) % count];
+        auto n1 = normal(p0, p1);
+        auto n2 = normal(p1, p2);
+        // Make sure the normals point away from the center.
+        if (dot(n1, center - p1) > 0.0f) {
+            n1 = -n1;
+        }
+        if (dot(n2, center - p1) > 0.0f) {
+            n2 = -n2;
+        }
+        auto factor = 1.0f + dot(n1, n2);
+        outer[i] = p1 + (n1 + n2) / factor * thickness_;
+    }
+    outline_.reserve(count * 6);
+    for (std::size_t i = 0; i < count; ++i) {
+        auto j = (i + 1) % count;
+        outline_.insert(outline_.end(), {
+            sf::Vertex(points_[i]), sf::Vertex(outer[i]), sf::Vertex(points_[j]),
+            sf::Vertex(points_[j]), sf::Vertex(outer[i]), sf::Vertex(outer[j]),
+        });
+    }
+}
+
+} // namespace CompuBrite::SFML
@@ -25,6 +25,7 @@
 */
 
 #include "CompuBrite/SFML/SpriteEntity.h"
+#include "CompuBrite/SFML/TextureAtlas.h"
 #include <SFML/Graphics/RenderTarget.hpp>
 
 namespace CompuBrite::SFML {
@@ -51,16 +52,34 @@ SpriteEntity::SpriteEntity(const sf::Texture &texture, const sf::IntRect &rect)
 {
 }
 
+SpriteEntity::SpriteEntity(const AtlasEntry &entry, int zOrder) :
+    IEntity(zOrder)
+{
+    if (entry.texture) {
+        sprite_.setTexture(*entry.texture);
+        sprite_.setTextureRect(entry.rect);
+    }
+}
+
 void
 SpriteEntity::setTexture(const sf::Texture &texture, bool resetRect)
 {
     sprite_.setTexture(texture, resetRect);
+    reshaped();
 }
 
 void
 SpriteEntity::setTextureRect(const sf::IntRect &rectangle)
 {
     sprite_.setTextureRect(rectangle);
+    reshaped();
+}
+
+void
+SpriteEntity::setColor(const sf::Color &color)
+{
+    sprite_.setColor(color);
+    invalidate();
 }
 
 const sf::Texture *
@@ -81,6 +100,70 @@ SpriteEntity::getColor() const
     return sprite_.getColor();
 }
 
+void
+SpriteEntity::setBlendMode(const sf::BlendMode &mode)
+{
+    blend_ = mode;
+    invalidate();
+}
+
+const sf::BlendMode &
+SpriteEntity::getBlendMode() const
+{
+    return blend_;
+}
+
+bool
+SpriteEntity::isBatchable() const
+{
+    return sprite_.getTexture() != nullptr;
+}
+
+const sf::Texture *
+SpriteEntity::getBatchTexture() const
+{
+    return sprite_.getTexture();
+}
+
+sf::BlendMode
+SpriteEntity::getBatchBlendMode() const
+{
+    return blend_;
+}
+
+void
+SpriteEntity::appendTriangles(std::vector<sf::Vertex> &vertices, const sf::Transform &transform) const
+{
+    auto bounds = sprite_.getLocalBounds();
+    auto rect = sprite_.getTextureRect();
+    auto color = sprite_.getColor();
+    auto combined = transform * sprite_.getTransform();
+    auto left = static_cast<float>(rect.left);
+    auto top = static_cast<float>(rect.top);
+    auto right = left + static_cast<float>(rect.width);
+    auto bottom = top + static_cast<float>(rect.height);
+
+    sf::Vertex quad[4] = {
+        sf::Vertex(combined.transformPoint(0.0f, 0.0f), color, {left, top}),
+        sf::Vertex(combined.transformPoint(0.0f, bounds.height), color, {left, bottom}),
+        sf::Vertex(combined.transformPoint(bounds.width, 0.0f), color, {right, top}),
+        sf::Vertex(combined.transformPoint(bounds.width, bounds.height), color, {right, bottom}),
+    };
+    vertices.insert(vertices.end(), {quad[0], quad[1], quad[2], quad[2], quad[1], quad[3]});
+}
+
+void
+SpriteEntity::setAlphaMask(const AlphaMask *mask)
+{
+    mask_ = mask;
+}
+
+const AlphaMask *
+SpriteEntity::getAlphaMask() const
+{
+    return mask_;
+}
+
 sf::FloatRect
 SpriteEntity::getLocalBounds() const
 {
@@ -90,6 +173,7 @@ SpriteEntity::getLocalBounds() const
 void
 SpriteEntity::drawThis(sf::RenderTarget &target, sf::RenderStates states) const
 {
+    states.blendMode = blend_;
     target.draw(sprite_, states);
 }
 
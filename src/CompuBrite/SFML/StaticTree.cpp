@@ -0,0 +1,91 @@
+/**
+ * The MIT License (MIT)
+ *
+ * @copyright
+ * Copyright (c) 2020 Rich Newman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @file
+ * @brief Implementation for StaticTree
+*/
+
+#include "CompuBrite/SFML/StaticTree.h"
+
+namespace CompuBrite::SFML {
+
+/// Nodes with this many items or fewer aren't split any further.
+static constexpr std::size_t itemsPerLeaf = 4;
+
+void
+StaticTree::build(std::vector<Item> items)
+{
+    nodes_.clear();
+    items_ = std::move(items);
+    if (items_.empty()) {
+        return;
+    }
+    // Splitting at the median leaves more than itemsPerLeaf / 2 items in each
+    // leaf, and a binary tree of n leaves has 2n - 1 nodes.
+    const auto leaves = std::max<std::size_t>(1, items_.size() / ((itemsPerLeaf + 1) / 2));
+    nodes_.reserve(2 * leaves - 1);
+    build(0, items_.size());
+}
+
+void
+StaticTree::clear()
+{
+    nodes_.clear();
+    items_.clear();
+}
+
+void
+StaticTree::build(std::size_t begin, std::size_t end)
+{
+    const auto index = nodes_.size();
+    nodes_.emplace_back();
+
+    auto aabb = items_[begin].aabb;
+    auto categories = items_[begin].categories;
+    auto centers = AABB(aabb.lower + aabb.upper, aabb.lower + aabb.upper);
+    for (auto item = begin + 1; item != end; ++item) {
+        const auto &entry = items_[item];
+        aabb = AABB::combine(aabb, entry.aabb);
+        categories |= entry.categories;
+        const auto center = entry.aabb.lower + entry.aabb.upper;
+        centers = AABB::combine(centers, AABB(center, center));
+    }
+
+    if (end - begin <= itemsPerLeaf) {
+        nodes_[index] = Node{aabb, categories, begin, end - begin, index + 1};
+        return;
+    }
+
+    // Split at the median along the axis the centers are most spread out on.
+    const bool xAxis = (centers.upper.x - centers.lower.x) >= (centers.upper.y - centers.lower.y);
+    const auto middle = begin + (end - begin) / 2;
+    std::nth_element(items_.begin() + begin, items_.begin() + middle, items_.begin() + end,
+                     [xAxis](const Item &lhs, const Item &rhs) {
+                         return xAxis ? lhs.aabb.lower.x + lhs.aabb.upper.x < rhs.aabb.lower.x + rhs.aabb.upper.x
+                                      : lhs.aabb.lower.y + lhs.aabb.upper.y < rhs.aabb.lower.y + rhs.aabb.upper.y;
+                     });
+    build(begin, middle);
+    build(middle, end);
+    nodes_[index] = Node{aabb, categories, begin, 0, nodes_.size()};
+}
+
+} // namespace CompuBrite::SFML
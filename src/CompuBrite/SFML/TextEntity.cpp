@@ -34,6 +34,15 @@ TextEntity::TextEntity(const sf::String &string, const sf::Font &font, unsigned
 {
 }
 
+void
+TextEntity::setString(const sf::String &string)
+{
+    if (string != text_.getString()) {
+        text_.setString(string);
+        invalidate();
+    }
+}
+
 void
 TextEntity::updateThis(sf::Time dt)
 {
@@ -42,6 +51,7 @@ TextEntity::updateThis(sf::Time dt)
         _elapsed = sf::Time::Zero;
         if (_blink) {
             _draw = !_draw;
+            invalidate();
         }
     }
 }
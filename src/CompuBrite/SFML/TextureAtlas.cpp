@@ -0,0 +1,121 @@
+/**
+ * The MIT License (MIT)
+ *
+ * @copyright
+ * Copyright (c) 2020 Rich Newman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @file
+ * @brief Implementation for TextureAtlas
+*/
+
+#include "CompuBrite/SFML/TextureAtlas.h"
+
+namespace CompuBrite::SFML {
+
+SkylinePacker::SkylinePacker(unsigned width, unsigned height) :
+    width_(width),
+    height_(height)
+{
+    clear();
+}
+
+void
+SkylinePacker::clear()
+{
+    skyline_.clear();
+    skyline_.push_back(Segment{0, 0, width_});
+}
+
+bool
+SkylinePacker::fit(std::size_t index, unsigned width, unsigned height, unsigned &y) const
+{
+    auto x = skyline_[index].x;
+    if (x + width > width_) {
+        return false;
+    }
+    y = 0;
+    for (auto remaining = width; remaining > 0; ++index) {
+        auto &segment = skyline_[index];
+        y = std::max(y, segment.y);
+        if (y + height > height_) {
+            return false;
+        }
+        remaining -= std::min(remaining, segment.width);
+    }
+    return true;
+}
+
+bool
+SkylinePacker::insert(unsigned width, unsigned height, sf::IntRect &rect)
+{
+    auto best = skyline_.size();
+    auto bestBottom = height_ + 1;
+    auto bestWidth = width_ + 1;
+    unsigned bestY = 0;
+    for (std::size_t i = 0; i < skyline_.size(); ++i) {
+        unsigned y;
+        if (!fit(i, width, height, y)) {
+            continue;
+        }
+        auto bottom = y + height;
+        if (bottom < bestBottom || (bottom == bestBottom && skyline_[i].width < bestWidth)) {
+            best = i;
+            bestBottom = bottom;
+            bestWidth = skyline_[i].width;
+            bestY = y;
+        }
+    }
+    if (best == skyline_.size()) {
+        return false;
+    }
+
+    auto x = skyline_[best].x;
+    rect = sf::IntRect(x, bestY, width, height);
+    skyline_.insert(skyline_.begin() + best, Segment{x, bestBottom, width});
+
+    // Trim the segments now hidden under the new one.
+    auto right = x + width;
+    for (auto i = best + 1; i < skyline_.size();) {
+        auto &segment = skyline_[i];
+        if (segment.x >= right) {
+            break;
+        }
+        auto end = segment.x + segment.width;
+        if (end <= right) {
+            skyline_.erase(skyline_.begin() + i);
+            continue;
+        }
+        segment.width = end - right;
+        segment.x = right;
+        break;
+    }
+
+    // Merge neighbours left at the same height.
+    for (std::size_t i = 0; i + 1 < skyline_.size();) {
+        if (skyline_[i].y == skyline_[i + 1].y) {
+            skyline_[i].width += skyline_[i + 1].width;
+            skyline_.erase(skyline_.begin() + i + 1);
+        } else {
+            ++i;
+        }
+    }
+    return true;
+}
+
+} // namespace CompuBrite::SFML
@@ -0,0 +1,186 @@
+/**
+ * The MIT License (MIT)
+ *
+ * @copyright
+ * Copyright (c) 2020 Rich Newman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @file
+ * @brief Implementation for TileMapEntity
+*/
+
+#include "CompuBrite/SFML/TileMapEntity.h"
+
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <SFML/Graphics/View.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace CompuBrite::SFML {
+
+TileMapEntity::TileMapEntity(const sf::Texture &tileset, const sf::Vector2u &tileSize,
+                             unsigned width, unsigned height, int zOrder) :
+    IEntity(zOrder),
+    tileset_(&tileset),
+    tileSize_(tileSize),
+    width_(width),
+    height_(height),
+    chunksX_((width + ChunkSize - 1) / ChunkSize),
+    chunksY_((height + ChunkSize - 1) / ChunkSize),
+    tiles_(static_cast<std::size_t>(width) * height, Empty),
+    chunks_(static_cast<std::size_t>(chunksX_) * chunksY_)
+{
+}
+
+void
+TileMapEntity::setTile(unsigned x, unsigned y, Tile tile)
+{
+    if (x >= width_ || y >= height_) {
+        return;
+    }
+    auto &current = tiles_[static_cast<std::size_t>(y) * width_ + x];
+    if (current == tile) {
+        return;
+    }
+    current = tile;
+    touch(x, y);
+    invalidate();
+}
+
+TileMapEntity::Tile
+TileMapEntity::getTile(unsigned x, unsigned y) const
+{
+    if (x >= width_ || y >= height_) {
+        return Empty;
+    }
+    return tiles_[static_cast<std::size_t>(y) * width_ + x];
+}
+
+void
+TileMapEntity::setTiles(const std::vector<Tile> &tiles)
+{
+    auto count = std::min(tiles.size(), tiles_.size());
+    std::copy_n(tiles.begin(), count, tiles_.begin());
+    std::fill(tiles_.begin() + count, tiles_.end(), Empty);
+    for (auto &chunk : chunks_) {
+        chunk.dirty = true;
+    }
+    invalidate();
+}
+
+void
+TileMapEntity::fill(Tile tile)
+{
+    std::fill(tiles_.begin(), tiles_.end(), tile);
+    for (auto &chunk : chunks_) {
+        chunk.dirty = true;
+    }
+    invalidate();
+}
+
+sf::FloatRect
+TileMapEntity::getLocalBounds() const
+{
+    return sf::FloatRect(0.0f, 0.0f, static_cast<float>(width_ * tileSize_.x),
+                         static_cast<float>(height_ * tileSize_.y));
+}
+
+void
+TileMapEntity::touch(unsigned x, unsigned y)
+{
+    chunks_[(y / ChunkSize) * chunksX_ + x / ChunkSize].dirty = true;
+}
+
+void
+TileMapEntity::bake(unsigned chunkX, unsigned chunkY) const
+{
+    auto &vertices = chunks_[chunkY * chunksX_ + chunkX].vertices;
+    vertices.clear();
+    auto columns = tileSize_.x ? tileset_->getSize().x / tileSize_.x : 0;
+    if (columns == 0) {
+        return;
+    }
+    auto w = static_cast<float>(tileSize_.x);
+    auto h = static_cast<float>(tileSize_.y);
+    auto endX = std::min(width_, (chunkX + 1) * ChunkSize);
+    auto endY = std::min(height_, (chunkY + 1) * ChunkSize);
+    for (auto y = chunkY * ChunkSize; y < endY; ++y) {
+        for (auto x = chunkX * ChunkSize; x < endX; ++x) {
+            auto tile = tiles_[static_cast<std::size_t>(y) * width_ + x];
+            if (tile == Empty) {
+                continue;
+            }
+            auto left = x * w;
+            auto top = y * h;
+            auto u = (tile % columns) * w;
+            auto v = (tile / columns) * h;
+            sf::Vertex quad[4] = {
+                sf::Vertex({left, top}, {u, v}),
+                sf::Vertex({left + w, top}, {u + w, v}),
+                sf::Vertex({left, top + h}, {u, v + h}),
+                sf::Vertex({left + w, top + h}, {u + w, v + h}),
+            };
+            for (auto corner : {0, 1, 2, 2, 1, 3}) {
+                vertices.append(quad[corner]);
+            }
+        }
+    }
+}
+
+void
+TileMapEntity::drawThis(sf::RenderTarget &target, sf::RenderStates states) const
+{
+    drawn_ = 0;
+    if (chunks_.empty() || tileSize_.x == 0 || tileSize_.y == 0) {
+        return;
+    }
+
+    // The part of the view covered by the map, in local coordinates.
+    auto &view = target.getView();
+    auto world = view.getInverseTransform().transformRect(sf::FloatRect(-1.0f, -1.0f, 2.0f, 2.0f));
+    auto local = states.transform.getInverse().transformRect(world);
+    auto chunkWidth = static_cast<float>(tileSize_.x * ChunkSize);
+    auto chunkHeight = static_cast<float>(tileSize_.y * ChunkSize);
+    auto first = [](float edge, float size, unsigned count) {
+        return static_cast<unsigned>(std::clamp(std::floor(edge / size), 0.0f, static_cast<float>(count)));
+    };
+    auto last = [](float edge, float size, unsigned count) {
+        return static_cast<unsigned>(std::clamp(std::ceil(edge / size), 0.0f, static_cast<float>(count)));
+    };
+    auto beginX = first(local.left, chunkWidth, chunksX_);
+    auto endX = last(local.left + local.width, chunkWidth, chunksX_);
+    auto beginY = first(local.top, chunkHeight, chunksY_);
+    auto endY = last(local.top + local.height, chunkHeight, chunksY_);
+
+    states.texture = tileset_;
+    for (auto y = beginY; y < endY; ++y) {
+        for (auto x = beginX; x < endX; ++x) {
+            auto &chunk = chunks_[y * chunksX_ + x];
+            if (chunk.dirty.exchange(false)) {
+                bake(x, y);
+            }
+            if (chunk.vertices.getVertexCount()) {
+                target.draw(chunk.vertices, states);
+                ++drawn_;
+            }
+        }
+    }
+}
+
+} // namespace CompuBrite::SFML
@@ -0,0 +1,82 @@
+/**
+ * The MIT License (MIT)
+ *
+ * @copyright
+ * Copyright (c) 2020 Rich Newman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @file
+ * @brief Implementation for TransformJournal
+*/
+
+#include "CompuBrite/SFML/TransformJournal.h"
+#include "CompuBrite/SFML/IEntity.h"
+
+#include <algorithm>
+
+namespace CompuBrite::SFML {
+
+void
+TransformJournal::record(IEntity &entity)
+{
+    auto frame = this->frame();
+    if (entity.journalFrame_.load(std::memory_order_relaxed) == frame) {
+        return;
+    }
+    auto l = lock();
+    frame = frame_.load(std::memory_order_relaxed);
+    if (entity.journalFrame_.exchange(frame, std::memory_order_relaxed) != frame) {
+        current_.push_back(&entity);
+    }
+}
+
+void
+TransformJournal::forget(IEntity &entity)
+{
+    if (entity.journalFrame_.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    auto l = lock();
+    current_.erase(std::remove(current_.begin(), current_.end(), &entity), current_.end());
+    changed_.erase(std::remove(changed_.begin(), changed_.end(), &entity), changed_.end());
+}
+
+bool
+TransformJournal::changedSince(const IEntity &entity, Frame frame) const
+{
+    for (auto found = &entity; found; found = found->parent_.load()) {
+        const auto last = found->journalFrame_.load(std::memory_order_relaxed);
+        // Compared as a difference, so the wrap of frame_ is handled.
+        if (last && static_cast<std::int32_t>(last - frame) >= 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void
+TransformJournal::advance()
+{
+    auto l = lock();
+    changed_.swap(current_);
+    current_.clear();
+    auto next = frame_.load(std::memory_order_relaxed) + 1;
+    frame_.store(next ? next : 1, std::memory_order_release);
+}
+
+} // namespace CompuBrite::SFML